@@ -0,0 +1,215 @@
+/*
+    Circular Buffer, a string oriented circular buffer implementation.
+    Copyright (C) 2015-2021 Enrico Rossi
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "cbuffer32.h"
+
+/*! Clear the buffer.
+ */
+void cbuffer32_clear(struct cbuffer32_t *cbuffer)
+{
+	cbuffer->idx = 0;
+	cbuffer->start = 0;
+	cbuffer->len = 0;
+}
+
+/*! Initialize the buffer.
+ *
+ * \param size the number of bytes the buffer can hold.
+ * \return the allocated struct, NULL if size is 0 or out of memory.
+ */
+struct cbuffer32_t *cbuffer32_init(const uint32_t size)
+{
+	struct cbuffer32_t *cbuffer;
+
+	if (!size)
+		return (NULL);
+
+	cbuffer = malloc(sizeof(struct cbuffer32_t));
+
+	if (!cbuffer)
+		return (NULL);
+
+	cbuffer->buffer = malloc(size);
+
+	if (!cbuffer->buffer) {
+		free(cbuffer);
+		return (NULL);
+	}
+
+	cbuffer->size = size;
+	cbuffer32_clear(cbuffer);
+	return (cbuffer);
+}
+
+/*! Remove the buffer.
+ */
+void cbuffer32_shut(struct cbuffer32_t *cbuffer)
+{
+	free(cbuffer->buffer);
+	free(cbuffer);
+}
+
+/*! Bytes from start to the end of the first segment.
+ */
+static uint32_t first_len(const struct cbuffer32_t *cbuffer)
+{
+	const uint32_t top = cbuffer->size - cbuffer->start;
+
+	return (cbuffer->len < top ? cbuffer->len : top);
+}
+
+/*! Remove n bytes from the start of the buffer.
+ *
+ * The first size of them are copied to data, the rest is lost.
+ *
+ * \param cbuffer the circular buffer.
+ * \param data the area where to copy the bytes.
+ * \param size sizeof(data)
+ * \param n the bytes to remove, no more than cbuffer->len.
+ * \return the number of bytes copied.
+ */
+static uint32_t bremove(struct cbuffer32_t *cbuffer, uint8_t *data,
+			const uint32_t size, const uint32_t n)
+{
+	const uint32_t first = first_len(cbuffer);
+	const uint32_t j = n < size ? n : size;
+	const uint32_t j1 = j < first ? j : first;
+	memcpy(data, cbuffer->buffer + cbuffer->start, j1);
+	memcpy(data + j1, cbuffer->buffer, j - j1);
+
+#ifdef CBUF_OVR_CHAR
+	const uint32_t n1 = n < first ? n : first;
+
+	memset(cbuffer->buffer + cbuffer->start, CBUF_OVR_CHAR, n1);
+	memset(cbuffer->buffer, CBUF_OVR_CHAR, n - n1);
+#endif
+
+	if (n < cbuffer->size - cbuffer->start)
+		cbuffer->start += n;
+	else
+		cbuffer->start = n - (cbuffer->size - cbuffer->start);
+
+	cbuffer->len -= n;
+	return (j);
+}
+
+/*! Get the stored buffer.
+ *
+ * Fetch from the start (cbuffer->start), at most size bytes.
+ *
+ * \param cbuffer the circular buffer.
+ * \param data the area where to copy the bytes.
+ * \param size sizeof(data)
+ * \return the number of bytes fetched.
+ */
+uint32_t cbuffer32_pop(struct cbuffer32_t *cbuffer, uint8_t *data,
+		       const uint32_t size)
+{
+	const uint32_t n = cbuffer->len < size ? cbuffer->len : size;
+
+	return (bremove(cbuffer, data, size, n));
+}
+
+/*! get a message present in the buffer.
+ *
+ * If no EOM is found then all the content of the buffer
+ * is copied and no EOM or \0 is added to the end.
+ *
+ * If the size of *data is less then the message in the buffer, then
+ * *data get filled and the rest of the message is lost.
+ *
+ * \param cbuffer the circular buffer.
+ * \param data the area where to copy the message if found.
+ * \param size sizeof(data)
+ * \param eom the EndOfMessage char.
+ * \return the number of char copied.
+ *
+ * \warning if the *data is filled, no EOM or \0 is added at the end.
+ */
+uint32_t cbuffer32_popm(struct cbuffer32_t *cbuffer, uint8_t *data,
+			const uint32_t size, const uint8_t eom)
+{
+	const uint32_t first = first_len(cbuffer);
+	const uint8_t *p;
+	uint32_t n;
+
+	p = memchr(cbuffer->buffer + cbuffer->start, eom, first);
+
+	if (p) {
+		n = (uint32_t)(p - (cbuffer->buffer + cbuffer->start)) + 1;
+	} else {
+		p = memchr(cbuffer->buffer, eom, cbuffer->len - first);
+
+		if (p)
+			n = first + (uint32_t)(p - cbuffer->buffer) + 1;
+		else
+			n = cbuffer->len;
+	}
+
+	return (bremove(cbuffer, data, size, n));
+}
+
+/*! add data to the buffer.
+ *
+ * \return FALSE if the buffer is full.
+ */
+uint8_t cbuffer32_push(struct cbuffer32_t *cbuffer, char rxc)
+{
+	if (cbuffer->len == cbuffer->size)
+		return (FALSE);
+
+	*(cbuffer->buffer + cbuffer->idx) = rxc;
+
+	if (++cbuffer->idx == cbuffer->size)
+		cbuffer->idx = 0;
+
+	cbuffer->len++;
+	return (TRUE);
+}
+
+/*! add n bytes to the buffer.
+ *
+ * \param cbuffer the circular buffer.
+ * \param data the bytes.
+ * \param n the number of bytes.
+ * \return the number of bytes added, less than n if the buffer
+ * gets full.
+ */
+uint32_t cbuffer32_pushn(struct cbuffer32_t *cbuffer, const uint8_t *data,
+			 const uint32_t n)
+{
+	const uint32_t room = cbuffer->size - cbuffer->len;
+	const uint32_t j = n < room ? n : room;
+	const uint32_t top = cbuffer->size - cbuffer->idx;
+	const uint32_t j1 = j < top ? j : top;
+
+	memcpy(cbuffer->buffer + cbuffer->idx, data, j1);
+	memcpy(cbuffer->buffer, data + j1, j - j1);
+
+	if (j1 < top)
+		cbuffer->idx += j1;
+	else
+		cbuffer->idx = j - j1;
+
+	cbuffer->len += j;
+	return (j);
+}
@@ -0,0 +1,78 @@
+/*
+    Circular Buffer, a string oriented circular buffer implementation.
+    Copyright (C) 2015-2021 Enrico Rossi
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <stdint.h>
+
+/*
+ * The size is given at runtime to cbuffer32_init(), up to
+ * UINT32_MAX bytes, different buffers can have different sizes.
+ *
+ * Optional:
+ * CBUF_OVR_CHAR
+ *
+ */
+#ifndef CBUFFER32_H
+#define CBUFFER32_H
+
+/*! Optional
+ *
+ * -D CBUF_OVR_CHAR='X'
+ *
+ * fill the popped bytes, a debug aid.
+ */
+
+#ifndef TRUE
+#define TRUE 1
+#define FALSE 0
+#endif
+
+/* Buffer structure
+ *
+ * [ | | | | | | | | | | | | | | | | | | | | | | | | ]
+ *  ^buffer   ^start                        ^idx    ^TOP
+ *            ^------------- len -----------^
+ *  ^---------------------- size -------------------^
+ *
+ * The bytes from start are in at most two contiguous segments,
+ * start to TOP and buffer to idx, pop and push copy them with
+ * memcpy() and popm() looks for the EOM with memchr().
+ * len tells full from empty, there is no overflow flag.
+ */
+struct cbuffer32_t {
+	uint8_t *buffer;
+	uint32_t idx;
+	uint32_t start;
+	/* size of the buffer */
+	uint32_t size;
+	/* how many byte are in the buffer */
+	uint32_t len;
+};
+
+void cbuffer32_clear(struct cbuffer32_t *cbuffer);
+struct cbuffer32_t *cbuffer32_init(const uint32_t size);
+void cbuffer32_shut(struct cbuffer32_t *cbuffer);
+uint32_t cbuffer32_pop(struct cbuffer32_t *cbuffer, uint8_t *data,
+		       const uint32_t size);
+uint32_t cbuffer32_popm(struct cbuffer32_t *cbuffer, uint8_t *data,
+			const uint32_t size, const uint8_t eom);
+uint8_t cbuffer32_push(struct cbuffer32_t *cbuffer, char rxc);
+uint32_t cbuffer32_pushn(struct cbuffer32_t *cbuffer, const uint8_t *data,
+			 const uint32_t n);
+
+#endif
@@ -0,0 +1,251 @@
+/*
+    Circular Buffer, a string oriented circular buffer implementation.
+    Copyright (C) 2015-2021 Enrico Rossi
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <limits.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include "cbuffer_spsc.h"
+
+/*! Initialize the buffer.
+ *
+ * \param size the number of bytes the buffer can hold.
+ * \return the allocated struct, NULL if size is 0 or out of memory.
+ */
+struct cbuffer_spsc_t *cbuffer_spsc_init(const unsigned int size)
+{
+	struct cbuffer_spsc_t *cbuffer;
+
+	if ((!size) || (size == UINT_MAX))
+		return (NULL);
+
+	cbuffer = malloc(sizeof(struct cbuffer_spsc_t));
+
+	if (!cbuffer)
+		return (NULL);
+
+	/* the spare byte */
+	cbuffer->buffer = malloc(size + 1);
+
+	if (!cbuffer->buffer) {
+		free(cbuffer);
+		return (NULL);
+	}
+
+	cbuffer->size = size;
+	cbuffer->TOP = size;
+	atomic_init(&cbuffer->idx, 0);
+	atomic_init(&cbuffer->start, 0);
+	return (cbuffer);
+}
+
+/*! Remove the buffer.
+ */
+void cbuffer_spsc_shut(struct cbuffer_spsc_t *cbuffer)
+{
+	free(cbuffer->buffer);
+	free(cbuffer);
+}
+
+/*! Bytes from s to i.
+ */
+static unsigned int distance(const struct cbuffer_spsc_t *cbuffer,
+			     const unsigned int s, const unsigned int i)
+{
+	if (i >= s)
+		return (i - s);
+	else
+		return (cbuffer->TOP + 1 - s + i);
+}
+
+/*! Index n bytes after i.
+ */
+static unsigned int advance(const struct cbuffer_spsc_t *cbuffer,
+			    const unsigned int i, const unsigned int n)
+{
+	if (n > cbuffer->TOP - i)
+		return (n - (cbuffer->TOP - i) - 1);
+	else
+		return (i + n);
+}
+
+/*! How many bytes are in the buffer.
+ *
+ * Exact on the consumer side, it can only grow meanwhile.
+ */
+unsigned int cbuffer_spsc_len(struct cbuffer_spsc_t *cbuffer)
+{
+	const unsigned int s = atomic_load_explicit(&cbuffer->start,
+						    memory_order_acquire);
+	const unsigned int i = atomic_load_explicit(&cbuffer->idx,
+						    memory_order_acquire);
+
+	return (distance(cbuffer, s, i));
+}
+
+/*! add data to the buffer.
+ *
+ * Producer only, safe in an interrupt.
+ *
+ * \return FALSE if the buffer is full.
+ */
+uint8_t cbuffer_spsc_push(struct cbuffer_spsc_t *cbuffer, char rxc)
+{
+	const unsigned int i = atomic_load_explicit(&cbuffer->idx,
+						    memory_order_relaxed);
+	/* acquire: the byte freed by the consumer is no longer read. */
+	const unsigned int s = atomic_load_explicit(&cbuffer->start,
+						    memory_order_acquire);
+
+	if (distance(cbuffer, s, i) == cbuffer->size)
+		return (FALSE);
+
+	*(cbuffer->buffer + i) = rxc;
+	/* release: the byte is written before the consumer sees it. */
+	atomic_store_explicit(&cbuffer->idx, advance(cbuffer, i, 1),
+			      memory_order_release);
+	return (TRUE);
+}
+
+/*! add n bytes to the buffer.
+ *
+ * Producer only, safe in an interrupt.
+ *
+ * \return the number of bytes added, less than n if the buffer
+ * gets full.
+ */
+unsigned int cbuffer_spsc_pushn(struct cbuffer_spsc_t *cbuffer,
+				const uint8_t *data, const unsigned int n)
+{
+	const unsigned int i = atomic_load_explicit(&cbuffer->idx,
+						    memory_order_relaxed);
+	const unsigned int s = atomic_load_explicit(&cbuffer->start,
+						    memory_order_acquire);
+	const unsigned int room = cbuffer->size - distance(cbuffer, s, i);
+	const unsigned int j = n < room ? n : room;
+	const unsigned int top = cbuffer->TOP + 1 - i;
+	const unsigned int j1 = j < top ? j : top;
+
+	memcpy(cbuffer->buffer + i, data, j1);
+	memcpy(cbuffer->buffer, data + j1, j - j1);
+	atomic_store_explicit(&cbuffer->idx, advance(cbuffer, i, j),
+			      memory_order_release);
+	return (j);
+}
+
+/*! Clear the buffer.
+ *
+ * Consumer only: everything pushed so far is dropped.
+ */
+void cbuffer_spsc_clear(struct cbuffer_spsc_t *cbuffer)
+{
+	const unsigned int i = atomic_load_explicit(&cbuffer->idx,
+						    memory_order_acquire);
+
+	atomic_store_explicit(&cbuffer->start, i, memory_order_release);
+}
+
+/*! Remove n bytes from start, the first size are copied to data.
+ *
+ * \param s the current start.
+ * \return the number of bytes copied.
+ */
+static unsigned int bremove(struct cbuffer_spsc_t *cbuffer,
+			    const unsigned int s, uint8_t *data,
+			    const unsigned int size, const unsigned int n)
+{
+	const unsigned int j = n < size ? n : size;
+	const unsigned int top = cbuffer->TOP + 1 - s;
+	const unsigned int j1 = j < top ? j : top;
+
+	memcpy(data, cbuffer->buffer + s, j1);
+	memcpy(data + j1, cbuffer->buffer, j - j1);
+	/* release: the bytes are copied before the producer reuses them. */
+	atomic_store_explicit(&cbuffer->start, advance(cbuffer, s, n),
+			      memory_order_release);
+	return (j);
+}
+
+/*! Get the stored buffer.
+ *
+ * Consumer only, the producer can push meanwhile.
+ *
+ * \param cbuffer the circular buffer.
+ * \param data the area where to copy the bytes.
+ * \param size sizeof(data)
+ * \return the number of bytes fetched.
+ */
+unsigned int cbuffer_spsc_pop(struct cbuffer_spsc_t *cbuffer,
+			      uint8_t *data, const unsigned int size)
+{
+	const unsigned int s = atomic_load_explicit(&cbuffer->start,
+						    memory_order_relaxed);
+	/* acquire: the bytes before idx are written. */
+	const unsigned int i = atomic_load_explicit(&cbuffer->idx,
+						    memory_order_acquire);
+	const unsigned int len = distance(cbuffer, s, i);
+
+	return (bremove(cbuffer, s, data, size, len < size ? len : size));
+}
+
+/*! get a message present in the buffer.
+ *
+ * Consumer only, the producer can push meanwhile.
+ * Only the bytes pushed up to the call are looked at: if no EOM
+ * is found then all of them are copied and no EOM or \0 is added
+ * to the end.
+ *
+ * If the size of *data is less then the message in the buffer, then
+ * *data get filled and the rest of the message is lost.
+ *
+ * \param cbuffer the circular buffer.
+ * \param data the area where to copy the message if found.
+ * \param size sizeof(data)
+ * \param eom the EndOfMessage char.
+ * \return the number of char copied.
+ */
+unsigned int cbuffer_spsc_popm(struct cbuffer_spsc_t *cbuffer,
+			       uint8_t *data, const unsigned int size,
+			       const uint8_t eom)
+{
+	const unsigned int s = atomic_load_explicit(&cbuffer->start,
+						    memory_order_relaxed);
+	const unsigned int i = atomic_load_explicit(&cbuffer->idx,
+						    memory_order_acquire);
+	const unsigned int len = distance(cbuffer, s, i);
+	const unsigned int top = cbuffer->TOP + 1 - s;
+	const unsigned int first = len < top ? len : top;
+	const uint8_t *p;
+	unsigned int n;
+
+	p = memchr(cbuffer->buffer + s, eom, first);
+
+	if (p) {
+		n = (unsigned int)(p - (cbuffer->buffer + s)) + 1;
+	} else {
+		p = memchr(cbuffer->buffer, eom, len - first);
+
+		if (p)
+			n = first + (unsigned int)(p - cbuffer->buffer) + 1;
+		else
+			n = len;
+	}
+
+	return (bremove(cbuffer, s, data, size, n));
+}
@@ -0,0 +1,84 @@
+/*
+    Circular Buffer, a string oriented circular buffer implementation.
+    Copyright (C) 2015-2021 Enrico Rossi
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <stdint.h>
+#include <stdatomic.h>
+
+/*
+ * Lock-free single producer, single consumer buffer, C11.
+ *
+ * The producer is typically a receive interrupt (or a signal
+ * handler), the consumer the main loop: pops run with interrupts
+ * enabled.
+ */
+#ifndef CBUFFER_SPSC_H
+#define CBUFFER_SPSC_H
+
+#ifndef TRUE
+#define TRUE 1
+#define FALSE 0
+#endif
+
+/* The indexes must be lock-free to be used from an interrupt. */
+_Static_assert(ATOMIC_INT_LOCK_FREE == 2,
+	       "cbuffer_spsc: atomic_uint is not lock-free");
+
+/* Buffer structure
+ *
+ * [ | | | | | | | | | | | | | | | | | | | | | | | | |#]
+ *  ^buffer   ^start                        ^idx       ^TOP
+ *            ^------------- len -----------^
+ *  ^---------------------- size -------------------^
+ *
+ * One spare byte (#) is allocated, so full and empty can be told
+ * apart by the indexes only, there is no len or overflow field.
+ * idx is written by the producer only, start by the consumer only,
+ * with a release store after the bytes have been copied. Neither
+ * side does a read-modify-write on a shared field.
+ */
+struct cbuffer_spsc_t {
+	uint8_t *buffer;
+	/* size of the buffer */
+	unsigned int size;
+	unsigned int TOP;
+	/* producer side */
+	atomic_uint idx;
+	/* consumer side */
+	atomic_uint start;
+};
+
+/* any side */
+struct cbuffer_spsc_t *cbuffer_spsc_init(const unsigned int size);
+void cbuffer_spsc_shut(struct cbuffer_spsc_t *cbuffer);
+unsigned int cbuffer_spsc_len(struct cbuffer_spsc_t *cbuffer);
+
+/* producer side */
+uint8_t cbuffer_spsc_push(struct cbuffer_spsc_t *cbuffer, char rxc);
+unsigned int cbuffer_spsc_pushn(struct cbuffer_spsc_t *cbuffer,
+				const uint8_t *data, const unsigned int n);
+
+/* consumer side */
+void cbuffer_spsc_clear(struct cbuffer_spsc_t *cbuffer);
+unsigned int cbuffer_spsc_pop(struct cbuffer_spsc_t *cbuffer,
+			      uint8_t *data, const unsigned int size);
+unsigned int cbuffer_spsc_popm(struct cbuffer_spsc_t *cbuffer,
+			       uint8_t *data, const unsigned int size,
+			       const uint8_t eom);
+
+#endif
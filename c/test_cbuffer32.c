@@ -0,0 +1,132 @@
+/*
+    Circular Buffer, a string oriented circular buffer implementation.
+    Copyright (C) 2015-2021 Enrico Rossi
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/* Random push, pushn, pop and popm checked against a linear copy of
+ * the content, for sizes around the 255 bytes limit of cbuffer_t.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "cbuffer32.h"
+
+#define EOM 'X'
+#define ROUNDS 100000
+#define MAX_SIZE 1024
+
+/* the expected content */
+uint8_t model[MAX_SIZE];
+uint32_t model_len;
+
+/* remove n bytes from the model, check the first j against data. */
+int model_remove(const uint8_t *data, const uint32_t n, const uint32_t j)
+{
+	if (memcmp(model, data, j))
+		return (FALSE);
+
+	memmove(model, model + n, model_len - n);
+	model_len -= n;
+	return (TRUE);
+}
+
+int run(const uint32_t size)
+{
+	struct cbuffer32_t *cbuffer;
+	uint8_t data[MAX_SIZE + 8];
+	uint32_t i, k, n, m, j;
+	uint8_t *p;
+
+	cbuffer = cbuffer32_init(size);
+
+	if (!cbuffer)
+		return (FALSE);
+
+	model_len = 0;
+
+	for (i = 0; i < ROUNDS; i++) {
+		n = (uint32_t)rand() % (size + 8);
+
+		switch (rand() % 4) {
+		case 0:
+			j = cbuffer32_push(cbuffer, 'a' + (i % 24));
+
+			if (j != (model_len < size))
+				return (FALSE);
+
+			if (j)
+				model[model_len++] = 'a' + (i % 24);
+
+			break;
+		case 1:
+			for (k = 0; k < n; k++)
+				data[k] = rand() % 8 ? 'a' + (rand() % 24) : EOM;
+
+			j = cbuffer32_pushn(cbuffer, data, n);
+			m = size - model_len;
+
+			if (j != (n < m ? n : m))
+				return (FALSE);
+
+			memcpy(model + model_len, data, j);
+			model_len += j;
+			break;
+		case 2:
+			j = cbuffer32_pop(cbuffer, data, n);
+			m = n < model_len ? n : model_len;
+
+			if ((j != m) || !model_remove(data, m, j))
+				return (FALSE);
+
+			break;
+		default:
+			j = cbuffer32_popm(cbuffer, data, n, EOM);
+			p = memchr(model, EOM, model_len);
+			m = p ? (uint32_t)(p - model) + 1 : model_len;
+
+			if ((j != (n < m ? n : m)) || !model_remove(data, m, j))
+				return (FALSE);
+		}
+
+		if (cbuffer->len != model_len)
+			return (FALSE);
+	}
+
+	cbuffer32_shut(cbuffer);
+	return (TRUE);
+}
+
+int main(void) {
+	const uint32_t sizes[] = { 1, 2, 16, 255, 256, 1000, MAX_SIZE };
+	uint8_t i;
+	int err = 0;
+
+	if (cbuffer32_init(0))
+		err++;
+
+	for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+		if (run(sizes[i])) {
+			printf("size %u: OK\n", sizes[i]);
+		} else {
+			printf("size %u: FAIL\n", sizes[i]);
+			err++;
+		}
+
+	return (err ? EXIT_FAILURE : EXIT_SUCCESS);
+}
@@ -0,0 +1,150 @@
+/*
+    Circular Buffer, a string oriented circular buffer implementation.
+    Copyright (C) 2015-2021 Enrico Rossi
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License along
+    with this program; if not, write to the Free Software Foundation, Inc.,
+    51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+/* The SIGALRM handler plays the receive interrupt: every timer tick
+ * it pushes a burst of a known byte stream, while the main loop pops
+ * with pop() and popm() with the signal never blocked, and checks
+ * that no byte is lost, duplicated or out of order.
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <signal.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#include "cbuffer_spsc.h"
+
+#define EOM 'X'
+/* small, to be full often */
+#define SIZE 37
+#define BURST 8
+#define TOTAL 200000
+/* the consumer stalls every STALL bytes */
+#define STALL 10000
+/* timer period in usec */
+#define TICK 50
+/* give up after sec */
+#define TIMEOUT 30
+
+struct cbuffer_spsc_t *cbuffer;
+/* the next byte of the stream to push */
+unsigned long produced;
+volatile sig_atomic_t full;
+
+/* the stream, a message every 17 bytes. */
+uint8_t stream(const unsigned long p)
+{
+	return (p % 17 == 16 ? EOM : 'a' + (p % 23));
+}
+
+void isr(int sig)
+{
+	uint8_t data[BURST];
+	unsigned int i, n;
+
+	(void)sig;
+	n = 1 + produced % BURST;
+
+	for (i = 0; i < n; i++)
+		data[i] = stream(produced + i);
+
+	/* the single byte push every other tick */
+	if (produced & 1) {
+		i = cbuffer_spsc_pushn(cbuffer, data, n);
+	} else {
+		n = 1;
+		i = cbuffer_spsc_push(cbuffer, data[0]);
+	}
+
+	/* full only if less than requested has been pushed. */
+	if (i < n)
+		full++;
+
+	produced += i;
+}
+
+int main(void) {
+	struct sigaction sa;
+	struct itimerval timer;
+	uint8_t data[SIZE];
+	unsigned long consumed;
+	unsigned int i, n;
+	sig_atomic_t stalls;
+	time_t end;
+	int err = 0;
+
+	cbuffer = cbuffer_spsc_init(SIZE);
+
+	if (!cbuffer)
+		return (EXIT_FAILURE);
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_handler = isr;
+	sigemptyset(&sa.sa_mask);
+	sa.sa_flags = SA_RESTART;
+	sigaction(SIGALRM, &sa, NULL);
+
+	timer.it_interval.tv_sec = 0;
+	timer.it_interval.tv_usec = TICK;
+	timer.it_value = timer.it_interval;
+	setitimer(ITIMER_REAL, &timer, NULL);
+
+	consumed = 0;
+	end = time(NULL) + TIMEOUT;
+
+	while ((consumed < TOTAL) && (time(NULL) < end) && !err) {
+		if (consumed & 1)
+			n = cbuffer_spsc_popm(cbuffer, data, sizeof(data), EOM);
+		else
+			n = cbuffer_spsc_pop(cbuffer, data, 3);
+
+		for (i = 0; i < n; i++)
+			if (data[i] != stream(consumed + i))
+				err++;
+
+		/* now and then stall until the buffer is full. */
+		if ((consumed % STALL) > ((consumed + n) % STALL)) {
+			stalls = full;
+
+			while ((full == stalls) && (time(NULL) < end))
+				;
+		}
+
+		consumed += n;
+	}
+
+	timer.it_value.tv_usec = 0;
+	timer.it_interval.tv_usec = 0;
+	setitimer(ITIMER_REAL, &timer, NULL);
+
+	printf("consumed: %lu, full: %d\n", consumed, (int)full);
+
+	if (err || (consumed < TOTAL) || (full < TOTAL / STALL)) {
+		printf("FAIL\n");
+		return (EXIT_FAILURE);
+	}
+
+	cbuffer_spsc_shut(cbuffer);
+	printf("OK\n");
+	return (EXIT_SUCCESS);
+}
@@ -19,7 +19,16 @@
 #ifndef _CBUFFER_H_
 #define _CBUFFER_H_
 
+#include <algorithm>
+#include <cstring>
 #include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "circular_buffer_detail.h"
+#if __cplusplus >= 201703L
+#include <memory_resource>
+#endif
 
 #ifndef CBUF_SIZE // Default buffer size
 #define CBUF_SIZE 16
@@ -33,44 +42,116 @@
   ^---------------------- size -------------------^
  */
 
-// CBuffer of D objects indexed by T type.
+/*! Default object handling.
+ *
+ * The E policy of CBuffer, to customize how the objects are
+ * stored and fetched write a struct with the same static members
+ * and use it as CBuffer<T, D, MyObject>.
+ * Being static the calls are inlined, no vtable is involved.
+ *
+ * The slots are raw memory: push() constructs the object in the
+ * slot, pop() moves it out and destroys it.
+ */
+template <typename D>
+struct CBufferObject {
+	static void pop(D* data, D* slot) { *data = std::move(*slot); slot->~D(); };
+	template <typename... Args>
+	static void push(D* slot, Args&&... args) {
+		::new (static_cast<void*>(slot)) D(std::forward<Args>(args)...); }
+};
+
+/*! A contiguous segment of objects inside the buffer.
+ *
+ * D can be const for read only segments.
+ */
 template <typename T, typename D>
+struct CBufferSegment {
+	D* data;
+	T len;
+};
+
+// CBuffer of D objects indexed by T type, E handles the objects,
+// A allocates the storage.
+template <typename T, typename D, typename E = CBufferObject<D>,
+				 typename A = std::allocator<D>>
 class CBuffer {
 	private:
-		// Fixed array size
-		std::unique_ptr<D[]> buffer_;
+		// Fixed array size, raw storage from A.
+		// The objects are constructed only when pushed.
+		A alloc_;
+		D* buffer_;
 		T idx_ { 0 };
 		T start_ { 0 };
 		bool overflow_ { false };
-		virtual void pop_object(D*);
-		virtual void push_object(D);
+		bool overwrite_ { false };
+		size_t dropped_ { 0 };
+		void pop_object(D* data) { E::pop(data, buffer_ + start_); };
+		template <typename... Args>
+		void push_object(Args&&... args) {
+			E::push(buffer_ + idx_, std::forward<Args>(args)...); }
+		template <typename... Args>
+		bool push_forward(Args&&...);
+		void destroy(const T, const T, std::true_type) {};
+		void destroy(const T, const T, std::false_type);
+		void destroy(const T from, const T n) {
+			destroy(from, n, std::is_trivially_destructible<D> {}); };
+		// bulk copy allowed: default handling and trivially copyable.
+		using memcpy_t = std::integral_constant<bool,
+					std::is_same<E, CBufferObject<D>>::value &&
+					std::is_trivially_copyable<D>::value>;
+		static void pop_objects(D*, D*, const size_t, std::true_type);
+		static void pop_objects(D*, D*, const size_t, std::false_type);
+		static void push_objects(D*, const D*, const size_t, std::true_type);
+		static void push_objects(D*, const D*, const size_t, std::false_type);
+		T popm(D*, const T, const D, std::true_type);
+		T popm(D*, const T, const D, std::false_type);
 	protected:
 		const T size_;
 		const T TOP_;
 		void set_start(T s) { start_ = s; };
     void clear_overflow() { overflow_ = false; };
+		T wrap(const size_t i) const { return (T)(i < size_ ? i : i - size_); };
+		void copy_out(D*, const T, const T) const;
+		void move_out(D*, const T, const T);
+		T find_eom(const T, const T, const D) const;
 	public:
 		// debugging methods
 		T size() const { return size_; };
 		bool overflow() const { return overflow_; };
+		bool overwrite() const { return overwrite_; };
+		void overwrite(bool o) { overwrite_ = o; };
+		size_t dropped() const { return dropped_; };
 		T index() const { return idx_; };
 		T start() const { return start_; };
-		// FIXME i < size_
+		// FIXME i < size_, only slots between start and idx are objects.
 		T operator[](T const i) const { return buffer_[i]; };
-		CBuffer(T = CBUF_SIZE); // contructor
-		virtual ~CBuffer() = default; // virtual destructor
-		virtual void clear();
-		virtual T len() const;
+		CBuffer(T = CBUF_SIZE, const A& = A()); // contructor
+		CBuffer(const CBuffer&) = delete;
+		CBuffer& operator=(const CBuffer&) = delete;
+		~CBuffer();
+		void clear();
+		T len() const;
 		bool popc(D*);
 		T pop(D*, const T);
 		T popm(D*, const T, const D);
-		bool push(D);
+		bool push(const D&);
+		bool push(D&&);
+		template <typename... Args>
+		bool emplace(Args&&...);
+		T push(const D*, const T);
+		// zero-copy read
+		T peek(CBufferSegment<T, const D>&, CBufferSegment<T, const D>&) const;
+		T consume(const T);
+		// zero-copy write
+		T reserve(CBufferSegment<T, D>&, CBufferSegment<T, D>&, const T);
+		T publish(const T);
 };
 
 //! Clear the buffer.
-template <typename T, typename D>
-void CBuffer<T, D>::clear()
+template <typename T, typename D, typename E, typename A>
+void CBuffer<T, D, E, A>::clear()
 {
+	destroy(start_, len());
 	idx_ = 0;
 	start_ = 0;
 	overflow_ = false;
@@ -84,8 +165,8 @@ void CBuffer<T, D>::clear()
  * @return len
  * @note const function does not change any attribute.
  */
-template <typename T, typename D>
-T CBuffer<T, D>::len() const
+template <typename T, typename D, typename E, typename A>
+T CBuffer<T, D, E, A>::len() const
 {
   if (idx_ == start_) {
     if (overflow_)
@@ -101,25 +182,42 @@ T CBuffer<T, D>::len() const
 
 /*! Initialize the buffer.
  *
- * \param plugin enable the check_eom function plugin.
- * \return the allocated struct.
+ * The storage is allocated with A and not initialized, no object
+ * is constructed and the memory is not touched: O(1) whatever the
+ * size, the pages get committed by the OS when written.
+ * The alignment of D is up to A, std::allocator honours over
+ * aligned types from C++17.
+ *
+ * \param sz the number of objects.
+ * \param alloc the allocator, i.e. a std::pmr::memory_resource*
+ * with A = std::pmr::polymorphic_allocator<D>.
  */
-template <typename T, typename D>
-CBuffer<T, D>::CBuffer(T sz) : size_ { sz }, TOP_ { (T)(sz - 1) }
+template <typename T, typename D, typename E, typename A>
+CBuffer<T, D, E, A>::CBuffer(T sz, const A& alloc) :
+	alloc_ { alloc },
+	buffer_ { std::allocator_traits<A>::allocate(alloc_, sz) },
+	size_ { sz }, TOP_ { (T)(sz - 1) }
 {
-	buffer_ = std::make_unique<D[]>(size_);
-	clear();
 }
 
-/*! Get single object from the buffer.
- *
- * This perform the operation, which can be overridden
- * depending on the type of object.
- */
-template <typename T, typename D>
-void CBuffer<T, D>::pop_object(D *data)
+//! Destroy the objects left and give the storage back to A.
+template <typename T, typename D, typename E, typename A>
+CBuffer<T, D, E, A>::~CBuffer()
 {
-	*data = buffer_[start_];
+	destroy(start_, len());
+	std::allocator_traits<A>::deallocate(alloc_, buffer_, size_);
+}
+
+//! Destroy n objects starting from the slot from.
+template <typename T, typename D, typename E, typename A>
+void CBuffer<T, D, E, A>::destroy(const T from, const T n, std::false_type)
+{
+	T j { from };
+
+	for (T i = 0; i < n; i++) {
+		buffer_[j].~D();
+		j = (j == TOP_) ? 0 : j + 1;
+	}
 }
 
 /*! Extract a single object from the buffer.
@@ -130,11 +228,11 @@ void CBuffer<T, D>::pop_object(D *data)
  * \return true if ok
  * \warning possible race condition!
  */
-template <typename T, typename D>
-bool CBuffer<T, D>::popc(D *data)
+template <typename T, typename D, typename E, typename A>
+bool CBuffer<T, D, E, A>::popc(D *data)
 {
 	if (len()) {
-		pop_object(data); // override me
+		pop_object(data); // E::pop()
 
 		if (start_ == TOP_)
 			start_ = 0;
@@ -150,9 +248,82 @@ bool CBuffer<T, D>::popc(D *data)
 	}
 }
 
+//! Bulk copy of trivially copyable objects out of the buffer.
+template <typename T, typename D, typename E, typename A>
+void CBuffer<T, D, E, A>::pop_objects(D* dst, D* src, const size_t n,
+		std::true_type)
+{
+	memcpy(dst, src, n * sizeof(D));
+}
+
+//! Move the objects out of the buffer one at a time through E.
+template <typename T, typename D, typename E, typename A>
+void CBuffer<T, D, E, A>::pop_objects(D* dst, D* src, const size_t n,
+		std::false_type)
+{
+	for (size_t i = 0; i < n; i++)
+		E::pop(dst + i, src + i);
+}
+
+//! Bulk copy of trivially copyable objects into the buffer.
+template <typename T, typename D, typename E, typename A>
+void CBuffer<T, D, E, A>::push_objects(D* dst, const D* src, const size_t n,
+		std::true_type)
+{
+	memcpy(dst, src, n * sizeof(D));
+}
+
+//! Copy the objects into the buffer one at a time through E.
+template <typename T, typename D, typename E, typename A>
+void CBuffer<T, D, E, A>::push_objects(D* dst, const D* src, const size_t n,
+		std::false_type)
+{
+	for (size_t i = 0; i < n; i++)
+		E::push(dst + i, src[i]);
+}
+
+/*! Copy n objects starting from the slot from.
+ *
+ * The objects are copied in at most two contiguous segments,
+ * from to the TOP_ and 0 onward. They stay in the buffer,
+ * E is not involved.
+ *
+ * \param data the destination area.
+ * \param from the first slot.
+ * \param n the number of objects, must be <= size_.
+ * \note the indexes are not changed.
+ */
+template <typename T, typename D, typename E, typename A>
+void CBuffer<T, D, E, A>::copy_out(D* data, const T from, const T n) const
+{
+	const T first { std::min<T>(n, (T)(size_ - from)) };
+
+	std::copy(buffer_ + from, buffer_ + from + first, data);
+
+	if (n > first)
+		std::copy(buffer_, buffer_ + n - first, data + first);
+}
+
+/*! Move n objects starting from the slot from.
+ *
+ * @sameas copy_out() but the objects are taken with E::pop().
+ */
+template <typename T, typename D, typename E, typename A>
+void CBuffer<T, D, E, A>::move_out(D* data, const T from, const T n)
+{
+	const T first { std::min<T>(n, (T)(size_ - from)) };
+
+	pop_objects(data, buffer_ + from, first, memcpy_t {});
+
+	if (n > first)
+		pop_objects(data + first, buffer_, n - first, memcpy_t {});
+}
+
 /*! Pop everything present in the buffer.
  *
  * start_ to the current idx_.
+ * The objects are copied in bulk, one or two contiguous segments,
+ * with a custom E one at a time with E::pop().
  *
  * \param data the area where to copy the message if found.
  * \param sizeofdata.
@@ -162,16 +333,33 @@ bool CBuffer<T, D>::popc(D *data)
  * \warning if the sizeofdata is bigger than the allocated data,
  * it will segfault or worse.
  */
-template <typename T, typename D>
-T CBuffer<T, D>::pop(D* data, const T sizeofdata)
+template <typename T, typename D, typename E, typename A>
+T CBuffer<T, D, E, A>::pop(D* data, const T sizeofdata)
 {
-	T j {0};
+	const T n { std::min(CBuffer<T, D, E, A>::len(), sizeofdata) };
 
-	// while there is space left on data and byte in the buffer
-	while ((j < sizeofdata) && popc(data + j))
-		j++;
+	if (n) {
+		move_out(data, start_, n);
+		start_ = wrap((size_t)start_ + n);
+		overflow_ = false;
+	}
 
-	return (j);
+	return (n);
+}
+
+/*! Search the EOM in n objects starting from the slot from.
+ *
+ * @sameas cbuffer_find_eom()
+ *
+ * \param from the first slot.
+ * \param n the number of objects to look into, must be <= size_.
+ * \param eom the EndOfMessage.
+ * \return the offset from "from" of the EOM, n if not found.
+ */
+template <typename T, typename D, typename E, typename A>
+T CBuffer<T, D, E, A>::find_eom(const T from, const T n, const D eom) const
+{
+	return (cbuffer_find_eom<T, D>(buffer_, size_, from, n, eom));
 }
 
 /*! Pop everything from start_ to EOM.
@@ -182,6 +370,9 @@ T CBuffer<T, D>::pop(D* data, const T sizeofdata)
  * If the size of data is less then the message in the buffer, then
  * data get filled and the rest of the message is left in the buffer.
  *
+ * With the default object handling the EOM is searched first,
+ * see find_eom(), and the message is then copied in bulk.
+ *
  * \param data the area where to copy the message.
  * \param sizeofdata.
  * \param eom the EndOfMessage.
@@ -190,8 +381,36 @@ T CBuffer<T, D>::pop(D* data, const T sizeofdata)
  * \note EOM is NOT copied.
  * \warning race condition!
  */
-template <typename T, typename D>
-T CBuffer<T, D>::popm(D* data, const T sizeofdata, const D eom)
+template <typename T, typename D, typename E, typename A>
+T CBuffer<T, D, E, A>::popm(D* data, const T sizeofdata, const D eom)
+{
+	return (popm(data, sizeofdata, eom,
+				std::is_same<E, CBufferObject<D>> {}));
+}
+
+//! popm(), search then bulk copy.
+template <typename T, typename D, typename E, typename A>
+T CBuffer<T, D, E, A>::popm(D* data, const T sizeofdata, const D eom,
+		std::true_type)
+{
+	const T n { std::min(len(), sizeofdata) };
+	const T j { find_eom(start_, n, eom) };
+	// the EOM is removed too, and copied as the original loop did.
+	const T k { (T)(j < n ? j + 1 : n) };
+
+	if (k) {
+		move_out(data, start_, k);
+		start_ = wrap((size_t)start_ + k);
+		overflow_ = false;
+	}
+
+	return (j);
+}
+
+//! popm(), one object at a time for a custom E.
+template <typename T, typename D, typename E, typename A>
+T CBuffer<T, D, E, A>::popm(D* data, const T sizeofdata, const D eom,
+		std::false_type)
 {
 	T j {0};
 
@@ -204,26 +423,126 @@ T CBuffer<T, D>::popm(D* data, const T sizeofdata, const D eom)
 	return (j);
 }
 
-/*! Push the single object.
+/*! Look at the content of the buffer without removing it.
  *
- * This function should be overridden.
+ * The objects from start_ are returned as two contiguous segments,
+ * the first up to the TOP_ and the second from the beginning of
+ * the buffer, its len is 0 if there is no wrap around.
+ * The indexes are not changed, use consume() when done.
+ *
+ * \param first the segment from start_.
+ * \param second the segment from 0.
+ * \return the total number of objects, len().
+ * \warning the segments are valid until the next pop or consume,
+ * E is not involved, the objects are the ones stored.
  */
-template <typename T, typename D>
-void CBuffer<T, D>::push_object(D c)
+template <typename T, typename D, typename E, typename A>
+T CBuffer<T, D, E, A>::peek(CBufferSegment<T, const D>& first,
+		CBufferSegment<T, const D>& second) const
+{
+	const T n { len() };
+
+	first.data = buffer_ + start_;
+	first.len = std::min<T>(n, (T)(size_ - start_));
+	second.data = buffer_;
+	second.len = n - first.len;
+
+	return (n);
+}
+
+/*! Remove n objects from the buffer.
+ *
+ * To be used after peek(), the objects are destroyed.
+ *
+ * \param n the number of objects to remove.
+ * \return the number of objects removed, less than n if the buffer
+ * has less objects.
+ */
+template <typename T, typename D, typename E, typename A>
+T CBuffer<T, D, E, A>::consume(const T n)
+{
+	const T j { std::min(len(), n) };
+
+	if (j) {
+		destroy(start_, j);
+		start_ = wrap((size_t)start_ + j);
+		overflow_ = false;
+	}
+
+	return (j);
+}
+
+/*! Reserve free space to be written in place.
+ *
+ * Up to n free slots from idx_ are returned as two contiguous
+ * segments, the first up to the TOP_ and the second from the
+ * beginning of the buffer. Nothing is added until publish().
+ *
+ * \param first the segment from idx_.
+ * \param second the segment from 0.
+ * \param n the number of slots wanted.
+ * \return the number of slots reserved, less than n if the buffer
+ * has not enough free space.
+ * \warning E is not involved, the slots are written as they are,
+ * D must be trivially copyable, the slots are raw memory.
+ */
+template <typename T, typename D, typename E, typename A>
+T CBuffer<T, D, E, A>::reserve(CBufferSegment<T, D>& first,
+		CBufferSegment<T, D>& second, const T n)
+{
+	static_assert(std::is_trivially_copyable<D>::value,
+			"reserve() needs a trivially copyable D");
+
+	const T j { std::min<T>(n, (T)(size_ - len())) };
+
+	first.data = buffer_ + idx_;
+	first.len = std::min<T>(j, (T)(size_ - idx_));
+	second.data = buffer_;
+	second.len = j - first.len;
+
+	return (j);
+}
+
+/*! Add n objects written in the reserved slots.
+ *
+ * The index is moved once for all the objects.
+ *
+ * \param n the number of objects written after reserve().
+ * \return the number of objects added, capped to the free space.
+ */
+template <typename T, typename D, typename E, typename A>
+T CBuffer<T, D, E, A>::publish(const T n)
 {
-	buffer_[idx_] = c;
+	const T len { CBuffer<T, D, E, A>::len() };
+	const T j { std::min<T>(n, (T)(size_ - len)) };
+
+	if (j) {
+		idx_ = wrap((size_t)idx_ + j);
+
+		if ((len + j) == size_)
+			overflow_ = true;
+	}
+
+	return (j);
 }
 
 /*! add data to the buffer.
+ *
+ * If the buffer is full and overwrite() is set the oldest object
+ * is destroyed to make room and counted in dropped().
  *
  * \note if overflow and EOM then the last char must be the EOM.
  *
  * \warning race condition with other functions.
  *  modified members data: overflow_, idx_, buffer_[idx_]
  */
-template <typename T, typename D>
-bool CBuffer<T, D>::push(D c)
+template <typename T, typename D, typename E, typename A>
+template <typename... Args>
+bool CBuffer<T, D, E, A>::push_forward(Args&&... args)
 {
+	if (overflow_ && overwrite_)
+		dropped_ += consume(1);
+
 	// If the buffer is full do nothing.
 	if (overflow_) {
 		return (false);
@@ -239,7 +558,7 @@ bool CBuffer<T, D>::push(D c)
 				overflow_ = true;
 		}
 
-		push_object(c); // override me
+		push_object(std::forward<Args>(args)...); // E::push()
 
 		if (idx_ == TOP_)
 			idx_ = 0;
@@ -250,4 +569,83 @@ bool CBuffer<T, D>::push(D c)
 	}
 }
 
+//! add a copy of the object to the buffer.
+template <typename T, typename D, typename E, typename A>
+bool CBuffer<T, D, E, A>::push(const D& c)
+{
+	return (push_forward(c));
+}
+
+//! move the object into the buffer.
+template <typename T, typename D, typename E, typename A>
+bool CBuffer<T, D, E, A>::push(D&& c)
+{
+	return (push_forward(std::move(c)));
+}
+
+/*! Construct an object from args in place in the buffer.
+ *
+ * Nothing is constructed if the buffer is full.
+ */
+template <typename T, typename D, typename E, typename A>
+template <typename... Args>
+bool CBuffer<T, D, E, A>::emplace(Args&&... args)
+{
+	return (push_forward(std::forward<Args>(args)...));
+}
+
+/*! add n objects to the buffer.
+ *
+ * The free space is reserved once and the objects are copied in
+ * bulk, one or two contiguous segments, with a custom E one at a
+ * time with E::push().
+ * With overwrite() set the oldest objects are dropped to make
+ * room, if n > size() only the last size() objects of data are
+ * added and the others are counted as dropped too.
+ *
+ * \param data the objects to add.
+ * \param n the number of objects in data.
+ * \return the number of objects added, less than n if the buffer
+ * got full, always n with overwrite().
+ */
+template <typename T, typename D, typename E, typename A>
+T CBuffer<T, D, E, A>::push(const D* data, const T n)
+{
+	if (overwrite_ && n) {
+		if (n > size_) {
+			dropped_ += consume(size_) + (n - size_);
+			push(data + (n - size_), size_);
+			return (n);
+		}
+
+		if (n > (T)(size_ - len()))
+			dropped_ += consume(n - (T)(size_ - len()));
+	}
+
+	const T len { CBuffer<T, D, E, A>::len() };
+	const T j { std::min<T>(n, (T)(size_ - len)) };
+	const T first { std::min<T>(j, (T)(size_ - idx_)) };
+
+	if (!j)
+		return (0);
+
+	push_objects(buffer_ + idx_, data, first, memcpy_t {});
+
+	if (j > first)
+		push_objects(buffer_, data + first, j - first, memcpy_t {});
+
+	idx_ = wrap((size_t)idx_ + j);
+
+	if ((len + j) == size_)
+		overflow_ = true;
+
+	return (j);
+}
+
+#if __cplusplus >= 201703L
+// CBuffer allocated from a std::pmr::memory_resource.
+template <typename T, typename D, typename E = CBufferObject<D>>
+using CBufferPmr = CBuffer<T, D, E, std::pmr::polymorphic_allocator<D>>;
+#endif
+
 #endif
@@ -0,0 +1,294 @@
+/* Circular Buffer, an object oriented circular buffer (C++20 coroutines).
+ * Copyright (C) 2015-2021 Enrico Rossi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _CBUFFER_CORO_H_
+#define _CBUFFER_CORO_H_
+
+#include <coroutine>
+#include <utility>
+#include "circular_buffer.h"
+
+/** Coroutine interface
+
+ co_await cbuffer.async_pop() suspends the coroutine while the buffer
+ is empty, co_await cbuffer.async_push(c) while it is full.
+
+ The suspended coroutines wait in FIFO queues. A push with a pop
+ waiting hands the object straight to the waiter, a pop with a push
+ waiting moves the waiter's object into the freed slot. Either way
+ the waiter is posted to the executor X, which must have a member
+ void post(std::coroutine_handle<>), and it resumes on the executor
+ thread with no context switch.
+
+ Not thread-safe: the buffer and all its coroutines run on the same
+ executor. The buffer must outlive the suspended coroutines.
+ */
+
+// CBuffer of D objects indexed by T type, with awaitable push and pop.
+template <typename T, typename D, typename X>
+class CBufferAsync {
+	private:
+		// a suspended coroutine in a FIFO queue.
+		struct waiter {
+			std::coroutine_handle<> h {};
+			waiter* next { nullptr };
+		};
+
+		// pop up to n objects in data, len fetched.
+		struct pop_waiter : waiter {
+			D* data;
+			T n;
+			T len { 0 };
+			pop_waiter(D* d, T sz) : data { d }, n { sz } {};
+		};
+
+		// push the object c.
+		struct push_waiter : waiter {
+			D c;
+			explicit push_waiter(D&& o) : c { std::move(o) } {};
+		};
+
+		template <typename W>
+		struct queue {
+			W* head { nullptr };
+			W* tail { nullptr };
+			bool empty() const { return (!head); };
+			void push(W*);
+			W* pop();
+		};
+
+		CBuffer<T, D> cbuffer_;
+		X& executor_;
+		queue<pop_waiter> pop_waiters_ {};
+		queue<push_waiter> push_waiters_ {};
+		bool try_pop(pop_waiter&);
+		bool try_push(D&);
+		void refill();
+
+	public:
+		// co_await async_pop() returns the object.
+		class pop_awaiter : pop_waiter {
+			private:
+				CBufferAsync& cb_;
+				D value_ {};
+			public:
+				explicit pop_awaiter(CBufferAsync& cb) :
+					pop_waiter { &value_, 1 }, cb_ { cb } {};
+				bool await_ready() { return (cb_.try_pop(*this)); };
+				void await_suspend(std::coroutine_handle<>);
+				D await_resume() { return (std::move(value_)); };
+		};
+
+		// co_await async_pop(data, n) returns the number of objects.
+		class batch_awaiter : pop_waiter {
+			private:
+				CBufferAsync& cb_;
+			public:
+				batch_awaiter(CBufferAsync& cb, D* data, T n) :
+					pop_waiter { data, n }, cb_ { cb } {};
+				// nothing to wait for with n 0.
+				bool await_ready() {
+					return (!this->n || cb_.try_pop(*this)); };
+				void await_suspend(std::coroutine_handle<>);
+				T await_resume();
+		};
+
+		// co_await async_push(c) returns when c is in the buffer.
+		class push_awaiter : push_waiter {
+			private:
+				CBufferAsync& cb_;
+			public:
+				push_awaiter(CBufferAsync& cb, D&& c) :
+					push_waiter { std::move(c) }, cb_ { cb } {};
+				bool await_ready() { return (cb_.try_push(this->c)); };
+				void await_suspend(std::coroutine_handle<>);
+				void await_resume() {};
+		};
+
+		CBufferAsync(X&, T = CBUF_SIZE); // contructor
+		CBufferAsync(const CBufferAsync&) = delete;
+		CBufferAsync& operator=(const CBufferAsync&) = delete;
+		T size() const { return (cbuffer_.size()); };
+		T len() const { return (cbuffer_.len()); };
+		pop_awaiter async_pop() { return (pop_awaiter { *this }); };
+		batch_awaiter async_pop(D* data, T n) {
+			return (batch_awaiter { *this, data, n }); };
+		push_awaiter async_push(D c) {
+			return (push_awaiter { *this, std::move(c) }); };
+		// not suspending, for producers or consumers out of a coroutine.
+		bool popc(D*);
+		bool push(D);
+};
+
+//! Append a waiter.
+template <typename T, typename D, typename X>
+template <typename W>
+void CBufferAsync<T, D, X>::queue<W>::push(W* w)
+{
+	w->next = nullptr;
+
+	if (tail)
+		tail->next = w;
+	else
+		head = w;
+
+	tail = w;
+}
+
+//! Remove the first waiter.
+template <typename T, typename D, typename X>
+template <typename W>
+W* CBufferAsync<T, D, X>::queue<W>::pop()
+{
+	W* w { head };
+
+	head = static_cast<W*>(w->next);
+
+	if (!head)
+		tail = nullptr;
+
+	return (w);
+}
+
+/*! Initialize the buffer.
+ *
+ * \param executor where the waiters are resumed.
+ * \param sz the number of objects.
+ */
+template <typename T, typename D, typename X>
+CBufferAsync<T, D, X>::CBufferAsync(X& executor, T sz) :
+	cbuffer_ { sz }, executor_ { executor }
+{
+}
+
+//! Move the objects of the waiting pushes into the free slots.
+template <typename T, typename D, typename X>
+void CBufferAsync<T, D, X>::refill()
+{
+	while (!push_waiters_.empty() && !cbuffer_.overflow()) {
+		push_waiter* w { push_waiters_.pop() };
+
+		cbuffer_.push(std::move(w->c));
+		executor_.post(w->h);
+	}
+}
+
+/*! Pop without suspending.
+ *
+ * \return false if the buffer is empty.
+ */
+template <typename T, typename D, typename X>
+bool CBufferAsync<T, D, X>::try_pop(pop_waiter& w)
+{
+	if (!cbuffer_.len())
+		return (false);
+
+	w.len = cbuffer_.pop(w.data, w.n);
+	refill();
+	return (true);
+}
+
+/*! Push without suspending.
+ *
+ * The first waiting pop, if any and with room, gets the object
+ * directly.
+ *
+ * \return false if the object must wait.
+ */
+template <typename T, typename D, typename X>
+bool CBufferAsync<T, D, X>::try_push(D& c)
+{
+	// keep the order of the pushes already waiting.
+	if (!push_waiters_.empty())
+		return (false);
+
+	if (!pop_waiters_.empty() &&
+			(pop_waiters_.head->len < pop_waiters_.head->n)) {
+		pop_waiter* w { pop_waiters_.pop() };
+
+		w->data[w->len++] = std::move(c);
+		executor_.post(w->h);
+		return (true);
+	}
+
+	return (cbuffer_.push(std::move(c)));
+}
+
+//! Queue the coroutine until an object is pushed.
+template <typename T, typename D, typename X>
+void CBufferAsync<T, D, X>::pop_awaiter::await_suspend(std::coroutine_handle<> h)
+{
+	this->h = h;
+	cb_.pop_waiters_.push(this);
+}
+
+//! Queue the coroutine until an object is pushed.
+template <typename T, typename D, typename X>
+void CBufferAsync<T, D, X>::batch_awaiter::await_suspend(std::coroutine_handle<> h)
+{
+	this->h = h;
+	cb_.pop_waiters_.push(this);
+}
+
+/*! The objects fetched.
+ *
+ * Resumed after a hand off, the objects pushed since are added.
+ */
+template <typename T, typename D, typename X>
+T CBufferAsync<T, D, X>::batch_awaiter::await_resume()
+{
+	if (this->len < this->n) {
+		this->len += cb_.cbuffer_.pop(this->data + this->len,
+				this->n - this->len);
+		cb_.refill();
+	}
+
+	return (this->len);
+}
+
+//! Queue the coroutine until a slot is free.
+template <typename T, typename D, typename X>
+void CBufferAsync<T, D, X>::push_awaiter::await_suspend(std::coroutine_handle<> h)
+{
+	this->h = h;
+	cb_.push_waiters_.push(this);
+}
+
+/*! Extract a single object, do not wait.
+ *
+ * @sameas CBuffer::popc()
+ */
+template <typename T, typename D, typename X>
+bool CBufferAsync<T, D, X>::popc(D* data)
+{
+	pop_waiter w { data, 1 };
+
+	return (try_pop(w));
+}
+
+/*! add data to the buffer, do not wait.
+ *
+ * @sameas CBuffer::push()
+ */
+template <typename T, typename D, typename X>
+bool CBufferAsync<T, D, X>::push(D c)
+{
+	return (try_push(c));
+}
+
+#endif
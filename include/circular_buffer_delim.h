@@ -0,0 +1,296 @@
+/* Circular Buffer, an object oriented circular buffer (delimiters).
+ * Copyright (C) 2015-2021 Enrico Rossi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _CBUFFER_DELIM_H_
+#define _CBUFFER_DELIM_H_
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include "circular_buffer.h"
+
+/** Buffer structure
+
+ [ | | | | | | | | | | | | | | | | | | | | | | | | ]
+  ^buffer   ^start             ^\r ^\n    ^idx    ^TOP
+            ^---- scanned_ ------------^
+                               ^matched_^
+  ^---------------------- size -------------------^
+
+ Messages end with a delimiter of one or more objects, i.e. "\r\n".
+ The search (Knuth-Morris-Pratt) is resumed where it stopped: the
+ objects already scanned from start and how much of the delimiter
+ they matched are kept between the calls, so each object is looked
+ at once however many times the consumer polls a partial message.
+ Removing objects from the start shifts the state, it restarts only
+ if a partial match is removed.
+ */
+
+// CBuffer of D objects indexed by T type, delimited messages.
+template <typename T, typename D, typename E = CBufferObject<D>,
+				 typename A = std::allocator<D>>
+class CBufferD : public CBuffer<T, D, E, A> {
+	private:
+		const T dlen_;
+		std::unique_ptr<D[]> delim_;
+		// KMP failure table, next_[i] delimiter prefix matched after
+		// a mismatch at i.
+		std::unique_ptr<T[]> next_;
+		T scanned_ { 0 };
+		T matched_ { 0 };
+		void shift(const size_t);
+	public:
+		CBufferD(const D*, const T, T = CBUF_SIZE, const A& = A()); // contructor
+		T scanned() const { return (scanned_); };
+
+		// declaration overload for the search state.
+		void clear();
+		bool popc(D*);
+		T pop(D*, const T);
+		T popm(D*, const T, const D);
+		T consume(const T);
+		bool push(const D&);
+		bool push(D&&);
+		template <typename... Args>
+		bool emplace(Args&&...);
+		T push(const D*, const T);
+
+		// new member functions
+		bool find(T*);
+		bool popd(D*, const T, T*);
+};
+
+/*! Contruct the buffer.
+ *
+ * \param delim the delimiter.
+ * \param dlen the number of objects of the delimiter.
+ * \throw std::invalid_argument if dlen is 0 or bigger than sz.
+ * @sameas CBuffer::CBuffer()
+ */
+template <typename T, typename D, typename E, typename A>
+CBufferD<T, D, E, A>::CBufferD(const D* delim, const T dlen, T sz,
+		const A& alloc) :
+	CBuffer<T, D, E, A>{sz, alloc}, dlen_ { dlen },
+	delim_ { std::make_unique<D[]>(dlen) },
+	next_ { std::make_unique<T[]>(dlen) }
+{
+	T k {0};
+
+	if ((!dlen) || (dlen > sz))
+		throw std::invalid_argument("CBufferD: invalid delimiter length");
+
+	std::copy(delim, delim + dlen, delim_.get());
+	next_[0] = 0;
+
+	for (T i = 1; i < dlen; i++) {
+		while (k && (delim_[i] != delim_[k]))
+			k = next_[k - 1];
+
+		if (delim_[i] == delim_[k])
+			k++;
+
+		next_[i] = k;
+	}
+}
+
+/*! n objects removed from the start.
+ *
+ * The state is kept if the partial match is still in the buffer.
+ */
+template <typename T, typename D, typename E, typename A>
+void CBufferD<T, D, E, A>::shift(const size_t n)
+{
+	if (n <= (size_t)(scanned_ - matched_)) {
+		scanned_ -= (T)n;
+	} else {
+		scanned_ = 0;
+		matched_ = 0;
+	}
+}
+
+/*! Search the delimiter, from where the last search stopped.
+ *
+ * \param n set to the length of the first message, the delimiter
+ * excluded.
+ * \return true if a delimiter is in the buffer.
+ */
+template <typename T, typename D, typename E, typename A>
+bool CBufferD<T, D, E, A>::find(T* n)
+{
+	CBufferSegment<T, const D> first, second;
+	const T len { CBuffer<T, D, E, A>::peek(first, second) };
+
+	while ((matched_ < dlen_) && (scanned_ < len)) {
+		const D& c { scanned_ < first.len ? first.data[scanned_] :
+			second.data[scanned_ - first.len] };
+
+		while (matched_ && (c != delim_[matched_]))
+			matched_ = next_[matched_ - 1];
+
+		if (c == delim_[matched_])
+			matched_++;
+
+		scanned_++;
+	}
+
+	*n = (T)(scanned_ - matched_);
+	return (matched_ == dlen_);
+}
+
+/*! Pop the first message and its delimiter.
+ *
+ * Nothing is removed if there is no delimiter in the buffer or if
+ * the message does not fit in data.
+ *
+ * \param data the area where to copy the message and the delimiter.
+ * \param sizeofdata.
+ * \param n set to the message length, the delimiter excluded, also
+ * when it does not fit.
+ * \return true if the message has been copied.
+ */
+template <typename T, typename D, typename E, typename A>
+bool CBufferD<T, D, E, A>::popd(D* data, const T sizeofdata, T* n)
+{
+	if (!find(n))
+		return (false);
+
+	if ((size_t)*n + dlen_ > sizeofdata)
+		return (false);
+
+	pop(data, (T)(*n + dlen_));
+	return (true);
+}
+
+/*! Clear the buffer and the search.
+ *
+ * @sameas CBuffer::clear()
+ */
+template <typename T, typename D, typename E, typename A>
+void CBufferD<T, D, E, A>::clear()
+{
+	CBuffer<T, D, E, A>::clear();
+	scanned_ = 0;
+	matched_ = 0;
+}
+
+/*! Extract a single object from the buffer.
+ *
+ * @sameas CBuffer::popc()
+ */
+template <typename T, typename D, typename E, typename A>
+bool CBufferD<T, D, E, A>::popc(D* data)
+{
+	if (!CBuffer<T, D, E, A>::popc(data))
+		return (false);
+
+	shift(1);
+	return (true);
+}
+
+/*! Pop everything present in the buffer.
+ *
+ * @sameas CBuffer::pop()
+ */
+template <typename T, typename D, typename E, typename A>
+T CBufferD<T, D, E, A>::pop(D* data, const T sizeofdata)
+{
+	const T j { CBuffer<T, D, E, A>::pop(data, sizeofdata) };
+
+	shift(j);
+	return (j);
+}
+
+/*! Pop everything from start_ to a single EOM.
+ *
+ * @sameas CBuffer::popm()
+ */
+template <typename T, typename D, typename E, typename A>
+T CBufferD<T, D, E, A>::popm(D* data, const T sizeofdata, const D eom)
+{
+	const T len { CBuffer<T, D, E, A>::len() };
+	const T j { CBuffer<T, D, E, A>::popm(data, sizeofdata, eom) };
+
+	shift(len - CBuffer<T, D, E, A>::len());
+	return (j);
+}
+
+/*! Remove n objects from the buffer.
+ *
+ * @sameas CBuffer::consume()
+ */
+template <typename T, typename D, typename E, typename A>
+T CBufferD<T, D, E, A>::consume(const T n)
+{
+	const T j { CBuffer<T, D, E, A>::consume(n) };
+
+	shift(j);
+	return (j);
+}
+
+/*! add a copy of the object to the buffer.
+ *
+ * The objects dropped with overwrite() shift the search.
+ */
+template <typename T, typename D, typename E, typename A>
+bool CBufferD<T, D, E, A>::push(const D& c)
+{
+	const size_t dropped { CBuffer<T, D, E, A>::dropped() };
+	const bool ok { CBuffer<T, D, E, A>::push(c) };
+
+	shift(CBuffer<T, D, E, A>::dropped() - dropped);
+	return (ok);
+}
+
+//! move the object into the buffer.
+template <typename T, typename D, typename E, typename A>
+bool CBufferD<T, D, E, A>::push(D&& c)
+{
+	const size_t dropped { CBuffer<T, D, E, A>::dropped() };
+	const bool ok { CBuffer<T, D, E, A>::push(std::move(c)) };
+
+	shift(CBuffer<T, D, E, A>::dropped() - dropped);
+	return (ok);
+}
+
+//! Construct an object from args in place in the buffer.
+template <typename T, typename D, typename E, typename A>
+template <typename... Args>
+bool CBufferD<T, D, E, A>::emplace(Args&&... args)
+{
+	const size_t dropped { CBuffer<T, D, E, A>::dropped() };
+	const bool ok { CBuffer<T, D, E, A>::emplace(std::forward<Args>(args)...) };
+
+	shift(CBuffer<T, D, E, A>::dropped() - dropped);
+	return (ok);
+}
+
+/*! add n objects to the buffer.
+ *
+ * @sameas CBuffer::push(const D*, const T)
+ */
+template <typename T, typename D, typename E, typename A>
+T CBufferD<T, D, E, A>::push(const D* data, const T n)
+{
+	const size_t dropped { CBuffer<T, D, E, A>::dropped() };
+	const T j { CBuffer<T, D, E, A>::push(data, n) };
+
+	shift(CBuffer<T, D, E, A>::dropped() - dropped);
+	return (j);
+}
+
+#endif
@@ -0,0 +1,124 @@
+/* Circular Buffer, an object oriented circular buffer (shared helpers).
+ * Copyright (C) 2015-2021 Enrico Rossi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _CBUFFER_DETAIL_H_
+#define _CBUFFER_DETAIL_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+/** Helpers shared by the buffers
+
+ Bulk copy and EOM search on the contiguous segments of a buffer,
+ picking memcpy() and memchr() when the type D allows them.
+ */
+
+// memcpy() allowed: trivially copyable objects.
+template <typename D>
+using cbuffer_memcpy_t = std::is_trivially_copyable<D>;
+
+// memchr() allowed: single byte integer objects.
+template <typename D>
+using cbuffer_memchr_t = std::integral_constant<bool, (sizeof(D) == 1) &&
+	(std::is_integral<D>::value || std::is_enum<D>::value)>;
+
+//! Bulk copy of trivially copyable objects.
+template <typename D>
+inline void cbuffer_copy(D* dst, const D* src, const size_t n, std::true_type)
+{
+	memcpy(dst, src, n * sizeof(D));
+}
+
+//! Bulk copy of objects with a copy assignment.
+template <typename D>
+inline void cbuffer_copy(D* dst, const D* src, const size_t n, std::false_type)
+{
+	std::copy(src, src + n, dst);
+}
+
+//! Copy n objects, with memcpy() if D allows it.
+template <typename D>
+inline void cbuffer_copy(D* dst, const D* src, const size_t n)
+{
+	cbuffer_copy(dst, src, n, cbuffer_memcpy_t<D> {});
+}
+
+//! Search in a contiguous segment with memchr().
+template <typename D>
+inline const D* cbuffer_find(const D* first, const D* last, const D eom,
+		std::true_type)
+{
+	const void* p { memchr(first, (unsigned char)eom, last - first) };
+
+	return (p ? static_cast<const D*>(p) : last);
+}
+
+//! Search in a contiguous segment one object at a time.
+template <typename D>
+inline const D* cbuffer_find(const D* first, const D* last, const D eom,
+		std::false_type)
+{
+	return (std::find(first, last, eom));
+}
+
+/*! Search the EOM in a contiguous segment.
+ *
+ * For single byte objects with memchr() which is vectorized by the
+ * C library (SSE2/AVX2 picked at run time on x86 glibc).
+ *
+ * \return the EOM, last if not found.
+ */
+template <typename D>
+inline const D* cbuffer_find(const D* first, const D* last, const D eom)
+{
+	return (cbuffer_find(first, last, eom, cbuffer_memchr_t<D> {}));
+}
+
+/*! Search the EOM in n objects starting from the slot from.
+ *
+ * The search is done in at most two contiguous segments, from
+ * to the end of the buffer and 0 onward.
+ *
+ * \param buffer the storage.
+ * \param size the number of slots of the buffer.
+ * \param from the first slot.
+ * \param n the number of objects to look into, must be <= size.
+ * \param eom the EndOfMessage.
+ * \return the offset from "from" of the EOM, n if not found.
+ */
+template <typename T, typename D>
+T cbuffer_find_eom(const D* buffer, const T size, const T from, const T n,
+		const D eom)
+{
+	const T first { std::min<T>(n, (T)(size - from)) };
+	const D* p { cbuffer_find(buffer + from, buffer + from + first, eom) };
+
+	if (p != (buffer + from + first))
+		return ((T)(p - buffer - from));
+
+	if (n > first) {
+		p = cbuffer_find(buffer, buffer + n - first, eom);
+		return ((T)(first + (p - buffer)));
+	}
+
+	return (n);
+}
+
+#endif
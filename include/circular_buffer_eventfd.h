@@ -0,0 +1,207 @@
+/* Circular Buffer, an object oriented circular buffer (eventfd).
+ * Copyright (C) 2015-2021 Enrico Rossi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _CBUFFER_EVENTFD_H_
+#define _CBUFFER_EVENTFD_H_
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <system_error>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include "circular_buffer_spsc.h"
+
+/** Readiness notification
+
+ A CBufferSPSC with an eventfd, to wait for the objects with
+ poll()/epoll() together with sockets and timers, Linux only.
+
+ The fd becomes readable when len() reaches the threshold, 1 by
+ default: the empty to not empty transition. Only the first push
+ after rearm() writes to the fd, the following ones see armed_
+ false and make no system call, so a burst costs one write.
+
+ Consumer loop:
+
+   epoll_wait(...);
+   do {
+     while (cbuffer.pop(data, n)) ...;
+   } while (cbuffer.rearm());
+
+ rearm() clears the fd, arms again and returns true if enough
+ objects arrived meanwhile: the producer may have seen armed_ false
+ and skipped the write. The producer publishes idx_ and then loads
+ armed_, the consumer stores armed_ and then loads idx_, with a
+ seq_cst fence on both sides one of them sees the other.
+ The threshold can be changed by either side, it is read by both.
+ */
+
+// Lock-free SPSC CBuffer of D objects indexed by T type, with a
+// pollable file descriptor.
+template <typename T, typename D>
+class CBufferEventfd : public CBufferSPSC<T, D> {
+	private:
+		const int fd_;
+		std::atomic<T> threshold_;
+		alignas(CBUF_CACHE_LINE) std::atomic<bool> armed_ { true };
+		static int open_fd();
+		void signal();
+	public:
+		CBufferEventfd(T = CBUF_SIZE, T = 1); // contructor
+		~CBufferEventfd() { close(fd_); };
+		int fd() const { return (fd_); };
+		T threshold() const { return (threshold_.load(std::memory_order_relaxed)); };
+		void threshold(T t) {
+			threshold_.store((T)(t ? t : 1), std::memory_order_relaxed); };
+		// consumer side
+		bool rearm();
+		// producer side, with the notification.
+		bool push(D);
+		template <typename Rep, typename Period>
+		bool push_wait(D, const std::chrono::duration<Rep, Period>&);
+		T publish(const T);
+};
+
+/*! Create the eventfd.
+ *
+ * \throw std::system_error if it fails.
+ */
+template <typename T, typename D>
+int CBufferEventfd<T, D>::open_fd()
+{
+	const int fd { eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC) };
+
+	if (fd < 0)
+		throw std::system_error(errno, std::system_category(), "eventfd");
+
+	return (fd);
+}
+
+/*! Initialize the buffer.
+ *
+ * \param sz the number of objects the buffer can hold.
+ * \param threshold len() that makes the fd readable.
+ */
+template <typename T, typename D>
+CBufferEventfd<T, D>::CBufferEventfd(T sz, T threshold) :
+	CBufferSPSC<T, D>{sz}, fd_ { open_fd() },
+	threshold_ { (T)(threshold ? threshold : 1) }
+{
+}
+
+/*! Producer side, make the fd readable if armed.
+ *
+ * To be called after the release store of idx_.
+ */
+template <typename T, typename D>
+void CBufferEventfd<T, D>::signal()
+{
+	const uint64_t one { 1 };
+	const T t { threshold_.load(std::memory_order_relaxed) };
+
+	// store idx_, then load armed_.
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	if (!armed_.load(std::memory_order_relaxed))
+		return;
+
+	if ((t > 1) && (this->len() < t))
+		return;
+
+	if (armed_.exchange(false, std::memory_order_relaxed))
+		if (write(fd_, &one, sizeof(one)) < 0) {
+			// EAGAIN: the counter is full, the fd is readable anyway.
+		}
+}
+
+/*! Arm the notification again.
+ *
+ * Consumer only, after the buffer has been drained.
+ *
+ * \return true if len() is already at the threshold, do not wait
+ * on the fd, pop again.
+ */
+template <typename T, typename D>
+bool CBufferEventfd<T, D>::rearm()
+{
+	uint64_t n;
+
+	if (read(fd_, &n, sizeof(n)) < 0) {
+		// EAGAIN: the fd was not readable, nothing to clear.
+	}
+
+	armed_.store(true, std::memory_order_relaxed);
+	// store armed_, then load idx_.
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	if (this->len() < threshold_.load(std::memory_order_relaxed))
+		return (false);
+
+	// if the producer took it, the fd is readable: it will be cleared
+	// by the next rearm().
+	return (armed_.exchange(false, std::memory_order_relaxed));
+}
+
+/*! add data to the buffer.
+ *
+ * @sameas CBufferSPSC::push()
+ */
+template <typename T, typename D>
+bool CBufferEventfd<T, D>::push(D c)
+{
+	if (!CBufferSPSC<T, D>::push(c))
+		return (false);
+
+	signal();
+	return (true);
+}
+
+/*! add data to the buffer, wait if the buffer is full.
+ *
+ * @sameas CBufferSPSC::push_wait()
+ */
+template <typename T, typename D>
+template <typename Rep, typename Period>
+bool CBufferEventfd<T, D>::push_wait(D c,
+		const std::chrono::duration<Rep, Period>& timeout)
+{
+	if (!CBufferSPSC<T, D>::push_wait(c, timeout))
+		return (false);
+
+	signal();
+	return (true);
+}
+
+/*! Add n objects written in the reserved slots.
+ *
+ * @sameas CBufferSPSC::publish()
+ */
+template <typename T, typename D>
+T CBufferEventfd<T, D>::publish(const T n)
+{
+	const T j { CBufferSPSC<T, D>::publish(n) };
+
+	if (j)
+		signal();
+
+	return (j);
+}
+
+#endif
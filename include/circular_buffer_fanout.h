@@ -0,0 +1,351 @@
+/* Circular Buffer, an object oriented circular buffer (fan-out).
+ * Copyright (C) 2015-2021 Enrico Rossi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _CBUFFER_FANOUT_H_
+#define _CBUFFER_FANOUT_H_
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include "circular_buffer.h"
+
+#ifndef CBUF_SIZE // Default buffer size
+#define CBUF_SIZE 16
+#endif
+
+#ifndef CBUF_CACHE_LINE
+#define CBUF_CACHE_LINE 64
+#endif
+
+/** Buffer structure
+
+ [ | | | | | | | | | | | | | | | | | | | | | | | | |#]
+  ^buffer ^start[1] ^start[0]  ^shadow[0] ^idx       ^TOP
+          ^------------ len ---------------^
+  ^---------------------- size -------------------^
+
+ One writer and N readers, every reader gets every object.
+ Each reader has its own shadow index, as CBufferS, moved by the
+ reads, and its own start, moved by commit(). The writer sees the
+ free space up to the slowest committed start, like the consumer
+ index of CBufferSPSC, and keeps a copy of it refreshed only when
+ the buffer looks full. The objects are written once and read in
+ place by all the readers.
+ One spare slot (#) is allocated as in CBufferSPSC.
+ */
+
+// Lock-free single writer, N readers CBuffer of D objects indexed
+// by T type. The reader id is 0..N-1.
+template <typename T, typename D, unsigned int N>
+class CBufferFanout {
+	static_assert(N > 0, "N must be greater than 0");
+
+	private:
+		// one cache line per reader, only commit() is seen by the writer.
+		struct alignas(CBUF_CACHE_LINE) reader {
+			std::atomic<T> start { 0 };
+			T shadow { 0 };
+			T idx_cache { 0 };
+		};
+
+		std::unique_ptr<D[]> buffer_;
+		const T size_;
+		const T TOP_;
+		// writer cache line, start_cache_ is the slowest start seen.
+		alignas(CBUF_CACHE_LINE) std::atomic<T> idx_ { 0 };
+		T start_cache_ { 0 };
+		reader readers_[N];
+		T next(T i) const { return (i == TOP_ ? 0 : (T)(i + 1)); };
+		T advance(T i, T n) const {
+			return ((T)((size_t)i + n > TOP_ ? (size_t)i + n - TOP_ - 1 : i + n)); };
+		T distance(T, T) const;
+		T free(T);
+		T available(reader&, T);
+	public:
+		// debugging methods
+		T size() const { return size_; };
+		static constexpr unsigned int readers() { return N; };
+		T index() const { return idx_.load(std::memory_order_relaxed); };
+		T start(unsigned int id) const { return readers_[id].shadow; };
+		CBufferFanout(T = CBUF_SIZE); // contructor
+		CBufferFanout(const CBufferFanout&) = delete;
+		CBufferFanout& operator=(const CBufferFanout&) = delete;
+		void clear();
+		// reader side, each reader only with its own id.
+		T len(unsigned int) const;
+		bool popc(unsigned int, D*);
+		T pop(unsigned int, D*, const T);
+		T peek(unsigned int, CBufferSegment<T, const D>&,
+				CBufferSegment<T, const D>&);
+		T consume(unsigned int, const T);
+		void commit(unsigned int);
+		void reset(unsigned int);
+		// writer side
+		bool push(D);
+		T push(const D*, const T);
+};
+
+//! Number of objects between start s and index i.
+template <typename T, typename D, unsigned int N>
+T CBufferFanout<T, D, N>::distance(T s, T i) const
+{
+	if (i >= s)
+		return (i - s);
+	else
+		return (TOP_ + 1 - s + i);
+}
+
+/*! Free slots seen by the writer.
+ *
+ * The start of every reader is loaded only if the cached slowest
+ * one does not leave room for n objects.
+ */
+template <typename T, typename D, unsigned int N>
+T CBufferFanout<T, D, N>::free(T n)
+{
+	const T i { idx_.load(std::memory_order_relaxed) };
+	T used { distance(start_cache_, i) };
+
+	if ((T)(size_ - used) < n) {
+		used = 0;
+
+		for (auto& r : readers_) {
+			// acquire: the reader is done with the slots before its start.
+			const T s { r.start.load(std::memory_order_acquire) };
+
+			if (distance(s, i) >= used) {
+				used = distance(s, i);
+				start_cache_ = s;
+			}
+		}
+	}
+
+	return ((T)(size_ - used));
+}
+
+/*! Objects from the shadow index of a reader.
+ *
+ * idx_ is loaded only if the cached copy shows less than n objects.
+ */
+template <typename T, typename D, unsigned int N>
+T CBufferFanout<T, D, N>::available(reader& r, T n)
+{
+	T a { distance(r.shadow, r.idx_cache) };
+
+	if (a < n) {
+		// acquire: the objects before idx_ are visible.
+		r.idx_cache = idx_.load(std::memory_order_acquire);
+		a = distance(r.shadow, r.idx_cache);
+	}
+
+	return (a);
+}
+
+/*! Initialize the buffer.
+ *
+ * \param sz the number of objects the buffer can hold.
+ */
+template <typename T, typename D, unsigned int N>
+CBufferFanout<T, D, N>::CBufferFanout(T sz) :
+	buffer_ { std::make_unique<D[]>((size_t)sz + 1) },
+	size_ { sz }, TOP_ { sz }
+{
+}
+
+/*! Clear the buffer and all the readers.
+ *
+ * \warning not thread-safe, no writer or reader must be running.
+ */
+template <typename T, typename D, unsigned int N>
+void CBufferFanout<T, D, N>::clear()
+{
+	idx_.store(0, std::memory_order_relaxed);
+	start_cache_ = 0;
+
+	for (auto& r : readers_) {
+		r.start.store(0, std::memory_order_relaxed);
+		r.shadow = 0;
+		r.idx_cache = 0;
+	}
+}
+
+/** LENght of the buffer for a reader.
+ *
+ * \param id the reader.
+ * @return the objects not read yet by the reader.
+ */
+template <typename T, typename D, unsigned int N>
+T CBufferFanout<T, D, N>::len(unsigned int id) const
+{
+	return (distance(readers_[id].shadow,
+				idx_.load(std::memory_order_acquire)));
+}
+
+/*! Read a single object.
+ *
+ * Reader only, the slot is not freed until commit().
+ *
+ * \param id the reader.
+ * \param data the area where to copy the object.
+ * \return true if ok
+ */
+template <typename T, typename D, unsigned int N>
+bool CBufferFanout<T, D, N>::popc(unsigned int id, D *data)
+{
+	reader& r { readers_[id] };
+
+	if (!available(r, 1))
+		return (false);
+
+	*data = buffer_[r.shadow];
+	r.shadow = next(r.shadow);
+	return (true);
+}
+
+/*! Read everything present.
+ *
+ * Reader only, the slots are not freed until commit().
+ *
+ * \param id the reader.
+ * \param data the area where to copy the objects.
+ * \param sizeofdata.
+ * \return the number of objects fetched.
+ */
+template <typename T, typename D, unsigned int N>
+T CBufferFanout<T, D, N>::pop(unsigned int id, D* data, const T sizeofdata)
+{
+	reader& r { readers_[id] };
+	const T a { available(r, sizeofdata) };
+	T j {0};
+
+	while ((j < sizeofdata) && (j < a)) {
+		*(data + j) = buffer_[r.shadow];
+		r.shadow = next(r.shadow);
+		j++;
+	}
+
+	return (j);
+}
+
+/*! Look at the objects not read yet, in place.
+ *
+ * Reader only, @sameas CBuffer::peek()
+ *
+ * \param id the reader.
+ * \warning the segments are valid until commit().
+ */
+template <typename T, typename D, unsigned int N>
+T CBufferFanout<T, D, N>::peek(unsigned int id,
+		CBufferSegment<T, const D>& first, CBufferSegment<T, const D>& second)
+{
+	reader& r { readers_[id] };
+	const T n { available(r, size_) };
+	const T top { (T)(TOP_ - r.shadow + 1) };
+
+	first.data = buffer_.get() + r.shadow;
+	first.len = n < top ? n : top;
+	second.data = buffer_.get();
+	second.len = n - first.len;
+
+	return (n);
+}
+
+/*! Move the shadow index of a reader past n objects.
+ *
+ * Reader only, to be used after peek(), the slots are not freed
+ * until commit().
+ *
+ * \return the number of objects skipped.
+ */
+template <typename T, typename D, unsigned int N>
+T CBufferFanout<T, D, N>::consume(unsigned int id, const T n)
+{
+	reader& r { readers_[id] };
+	const T a { available(r, n) };
+	const T j { n < a ? n : a };
+
+	r.shadow = advance(r.shadow, j);
+	return (j);
+}
+
+/*! Free the objects read by a reader.
+ *
+ * Reader only, a single release store. The slots are reused by
+ * the writer once every reader has committed them.
+ */
+template <typename T, typename D, unsigned int N>
+void CBufferFanout<T, D, N>::commit(unsigned int id)
+{
+	readers_[id].start.store(readers_[id].shadow, std::memory_order_release);
+}
+
+/*! Roll back the shadow index of a reader to its last commit().
+ *
+ * Reader only, the objects read since will be read again.
+ */
+template <typename T, typename D, unsigned int N>
+void CBufferFanout<T, D, N>::reset(unsigned int id)
+{
+	readers_[id].shadow = readers_[id].start.load(std::memory_order_relaxed);
+}
+
+/*! add data to the buffer.
+ *
+ * Writer only.
+ *
+ * \return false if the slowest reader has not committed enough.
+ */
+template <typename T, typename D, unsigned int N>
+bool CBufferFanout<T, D, N>::push(D c)
+{
+	const T i { idx_.load(std::memory_order_relaxed) };
+
+	if (!free(1))
+		return (false);
+
+	buffer_[i] = c;
+	// release: the object is written before it becomes visible.
+	idx_.store(next(i), std::memory_order_release);
+	return (true);
+}
+
+/*! add n objects to the buffer.
+ *
+ * Writer only, all of them become visible at once.
+ *
+ * \return the number of objects added, capped to the free space.
+ */
+template <typename T, typename D, unsigned int N>
+T CBufferFanout<T, D, N>::push(const D* data, const T n)
+{
+	T i { idx_.load(std::memory_order_relaxed) };
+	const T f { free(n) };
+	const T j { n < f ? n : f };
+
+	for (T k = 0; k < j; k++) {
+		buffer_[i] = data[k];
+		i = next(i);
+	}
+
+	if (j)
+		idx_.store(i, std::memory_order_release);
+
+	return (j);
+}
+
+#endif
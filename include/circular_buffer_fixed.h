@@ -0,0 +1,192 @@
+/* Circular Buffer, an object oriented circular buffer (fixed size).
+ * Copyright (C) 2015-2021 Enrico Rossi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _CBUFFER_FIXED_H_
+#define _CBUFFER_FIXED_H_
+
+#include <algorithm>
+#include "circular_buffer_detail.h"
+
+/** Buffer structure
+
+ [ | | | | | | | | | | | | | | | | | | | | | | | | ]
+  ^buffer   ^start                        ^idx    ^TOP
+            ^------------ len() ----------^
+  ^---------------------- N ----------------------^
+
+ The objects are stored inside the class, no heap allocation, and
+ the size N is a compile time constant.
+ */
+
+// CBuffer of N D objects indexed by T type.
+// Same API of CBuffer<T, D>, the constructor takes no size.
+template <typename T, typename D, T N>
+class CBufferFixed {
+	static_assert(N > 0, "N must be greater than 0");
+
+	private:
+		D buffer_[N];
+		T idx_ { 0 };
+		T start_ { 0 };
+		bool overflow_ { false };
+		static constexpr T wrap(const size_t i) { return (T)(i < N ? i : i - N); };
+	public:
+		// debugging methods
+		static constexpr T size() { return N; };
+		bool overflow() const { return overflow_; };
+		T index() const { return idx_; };
+		T start() const { return start_; };
+		// FIXME i < size_
+		T operator[](T const i) const { return buffer_[i]; };
+		CBufferFixed() = default;
+		void clear();
+		T len() const;
+		bool popc(D*);
+		T pop(D*, const T);
+		T popm(D*, const T, const D);
+		bool push(D);
+		T push(const D*, const T);
+};
+
+//! Clear the buffer.
+template <typename T, typename D, T N>
+void CBufferFixed<T, D, N>::clear()
+{
+	idx_ = 0;
+	start_ = 0;
+	overflow_ = false;
+}
+
+/** LENght of the buffer
+ *
+ * @sameas CBuffer::len()
+ */
+template <typename T, typename D, T N>
+T CBufferFixed<T, D, N>::len() const
+{
+	if (idx_ == start_)
+		return (overflow_ ? N : 0);
+	else if (idx_ > start_)
+		return (idx_ - start_);
+	else
+		return (N - start_ + idx_);
+}
+
+/*! Extract a single object from the buffer.
+ *
+ * @sameas CBuffer::popc()
+ */
+template <typename T, typename D, T N>
+bool CBufferFixed<T, D, N>::popc(D *data)
+{
+	if (len()) {
+		*data = buffer_[start_];
+		start_ = wrap((size_t)start_ + 1);
+		overflow_ = false;
+		return (true);
+	} else {
+		return (false);
+	}
+}
+
+/*! Pop everything present in the buffer.
+ *
+ * @sameas CBuffer::pop()
+ */
+template <typename T, typename D, T N>
+T CBufferFixed<T, D, N>::pop(D* data, const T sizeofdata)
+{
+	const T n { std::min(len(), sizeofdata) };
+	const T first { std::min<T>(n, (T)(N - start_)) };
+
+	if (n) {
+		cbuffer_copy(data, buffer_ + start_, first);
+
+		if (n > first)
+			cbuffer_copy(data + first, buffer_, n - first);
+
+		start_ = wrap((size_t)start_ + n);
+		overflow_ = false;
+	}
+
+	return (n);
+}
+
+/*! Pop everything from start_ to EOM.
+ *
+ * The EOM is searched first, then the message is copied in bulk.
+ *
+ * @sameas CBuffer::popm()
+ */
+template <typename T, typename D, T N>
+T CBufferFixed<T, D, N>::popm(D* data, const T sizeofdata, const D eom)
+{
+	const T n { std::min(len(), sizeofdata) };
+	const T j { cbuffer_find_eom<T, D>(buffer_, N, start_, n, eom) };
+
+	// the EOM is removed and copied too.
+	pop(data, (T)(j < n ? j + 1 : n));
+	return (j);
+}
+
+/*! add data to the buffer.
+ *
+ * @sameas CBuffer::push()
+ */
+template <typename T, typename D, T N>
+bool CBufferFixed<T, D, N>::push(D c)
+{
+	if (overflow_)
+		return (false);
+
+	buffer_[idx_] = c;
+	idx_ = wrap((size_t)idx_ + 1);
+
+	if (idx_ == start_)
+		overflow_ = true;
+
+	return (true);
+}
+
+/*! add n objects to the buffer.
+ *
+ * @sameas CBuffer::push(const D*, const T)
+ */
+template <typename T, typename D, T N>
+T CBufferFixed<T, D, N>::push(const D* data, const T n)
+{
+	const T j { std::min<T>(n, (T)(N - len())) };
+	const T first { std::min<T>(j, (T)(N - idx_)) };
+
+	if (!j)
+		return (0);
+
+	cbuffer_copy(buffer_ + idx_, data, first);
+
+	if (j > first)
+		cbuffer_copy(buffer_, data + first, j - first);
+
+	idx_ = wrap((size_t)idx_ + j);
+
+	if (idx_ == start_)
+		overflow_ = true;
+
+	return (j);
+}
+
+#endif
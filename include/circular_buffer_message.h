@@ -0,0 +1,282 @@
+/* Circular Buffer, an object oriented circular buffer (messages).
+ * Copyright (C) 2015-2021 Enrico Rossi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _CBUFFER_MESSAGE_H_
+#define _CBUFFER_MESSAGE_H_
+
+#include <algorithm>
+#include "circular_buffer.h"
+
+/** Buffer structure
+
+ [ | | | | | | | | | | | | | | | | | | | | | | | | ]
+  ^buffer   ^start  ^EOM       ^EOM       ^idx    ^TOP
+            ^--- messages() = 2 ---^
+  ^---------------------- size -------------------^
+
+ The EOM is fixed at construction and every push, pop and drop
+ updates the count of the EOMs in the buffer, so messages() tells
+ in O(1) if a whole message is there, without a scan.
+ Every object is looked at once when pushed and once when removed.
+ */
+
+// CBuffer of EOM terminated messages of D objects indexed by T type.
+template <typename T, typename D, typename E = CBufferObject<D>,
+				 typename A = std::allocator<D>>
+class CBufferM : public CBuffer<T, D, E, A> {
+	private:
+		const D eom_;
+		T messages_ { 0 };
+		T count_front(const T) const;
+		template <typename F>
+		bool push_one(F);
+	public:
+		CBufferM(const D, T = CBUF_SIZE, const A& = A()); // contructor
+		D eom() const { return (eom_); };
+		T messages() const { return (messages_); };
+
+		// declaration overload for the EOM count.
+		void clear();
+		bool popc(D*);
+		T pop(D*, const T);
+		T popm(D*, const T, const D);
+		T consume(const T);
+		bool push(const D&);
+		bool push(D&&);
+		template <typename... Args>
+		bool emplace(Args&&...);
+		T push(const D*, const T);
+		T publish(const T);
+
+		// new member functions
+		bool popmsg(D*, const T, T*);
+};
+
+/*! Contruct the buffer.
+ *
+ * \param eom the EndOfMessage.
+ * @sameas CBuffer::CBuffer()
+ */
+template <typename T, typename D, typename E, typename A>
+CBufferM<T, D, E, A>::CBufferM(const D eom, T size, const A& alloc) :
+	CBuffer<T, D, E, A>{size, alloc}, eom_ { eom }
+{
+}
+
+//! EOMs in the first n objects from start.
+template <typename T, typename D, typename E, typename A>
+T CBufferM<T, D, E, A>::count_front(const T n) const
+{
+	CBufferSegment<T, const D> first, second;
+	const T len { std::min(CBuffer<T, D, E, A>::peek(first, second), n) };
+	const T j { std::min(first.len, len) };
+
+	return ((T)(std::count(first.data, first.data + j, eom_) +
+				std::count(second.data, second.data + len - j, eom_)));
+}
+
+/*! Clear the buffer and the EOM count.
+ *
+ * @sameas CBuffer::clear()
+ */
+template <typename T, typename D, typename E, typename A>
+void CBufferM<T, D, E, A>::clear()
+{
+	CBuffer<T, D, E, A>::clear();
+	messages_ = 0;
+}
+
+/*! Extract a single object from the buffer.
+ *
+ * @sameas CBuffer::popc()
+ */
+template <typename T, typename D, typename E, typename A>
+bool CBufferM<T, D, E, A>::popc(D* data)
+{
+	if (!CBuffer<T, D, E, A>::popc(data))
+		return (false);
+
+	if (*data == eom_)
+		messages_--;
+
+	return (true);
+}
+
+/*! Pop everything present in the buffer.
+ *
+ * @sameas CBuffer::pop()
+ */
+template <typename T, typename D, typename E, typename A>
+T CBufferM<T, D, E, A>::pop(D* data, const T sizeofdata)
+{
+	messages_ -= count_front(sizeofdata);
+	return (CBuffer<T, D, E, A>::pop(data, sizeofdata));
+}
+
+/*! Pop everything from start_ to EOM, partial messages too.
+ *
+ * @sameas CBuffer::popm()
+ */
+template <typename T, typename D, typename E, typename A>
+T CBufferM<T, D, E, A>::popm(D* data, const T sizeofdata, const D eom)
+{
+	const T len { CBuffer<T, D, E, A>::len() };
+	const T j { CBuffer<T, D, E, A>::popm(data, sizeofdata, eom) };
+
+	// j objects and the EOM removed.
+	if ((eom == eom_) && ((T)(len - CBuffer<T, D, E, A>::len()) == (T)(j + 1)))
+		messages_--;
+	else if (eom != eom_)
+		messages_ -= (T)std::count(data, data + (len - CBuffer<T, D, E, A>::len()), eom_);
+
+	return (j);
+}
+
+/*! Pop a whole message.
+ *
+ * Nothing is removed if there is no complete message in the buffer,
+ * or if it does not fit in data.
+ *
+ * \param data the area where to copy the message and the EOM.
+ * \param sizeofdata.
+ * \param n set to the message length, EOM excluded, also when it
+ * does not fit.
+ * \return true if the message has been copied.
+ */
+template <typename T, typename D, typename E, typename A>
+bool CBufferM<T, D, E, A>::popmsg(D* data, const T sizeofdata, T* n)
+{
+	*n = 0;
+
+	if (!messages_)
+		return (false);
+
+	*n = CBuffer<T, D, E, A>::find_eom(CBuffer<T, D, E, A>::start(),
+			CBuffer<T, D, E, A>::len(), eom_);
+
+	if (*n >= sizeofdata)
+		return (false);
+
+	CBuffer<T, D, E, A>::pop(data, (T)(*n + 1));
+	messages_--;
+	return (true);
+}
+
+/*! Remove n objects from the buffer.
+ *
+ * @sameas CBuffer::consume()
+ */
+template <typename T, typename D, typename E, typename A>
+T CBufferM<T, D, E, A>::consume(const T n)
+{
+	messages_ -= count_front(n);
+	return (CBuffer<T, D, E, A>::consume(n));
+}
+
+/*! Push one object and count it.
+ *
+ * The object dropped by a push with overwrite() is uncounted first.
+ */
+template <typename T, typename D, typename E, typename A>
+template <typename F>
+bool CBufferM<T, D, E, A>::push_one(F push)
+{
+	CBufferSegment<T, const D> first, second;
+
+	if (CBuffer<T, D, E, A>::overflow() && CBuffer<T, D, E, A>::overwrite())
+		messages_ -= count_front(1);
+
+	if (!push())
+		return (false);
+
+	CBuffer<T, D, E, A>::peek(first, second);
+
+	if ((second.len ? second.data[second.len - 1] :
+				first.data[first.len - 1]) == eom_)
+		messages_++;
+
+	return (true);
+}
+
+//! add a copy of the object to the buffer.
+template <typename T, typename D, typename E, typename A>
+bool CBufferM<T, D, E, A>::push(const D& c)
+{
+	return (push_one([&] { return (CBuffer<T, D, E, A>::push(c)); }));
+}
+
+//! move the object into the buffer.
+template <typename T, typename D, typename E, typename A>
+bool CBufferM<T, D, E, A>::push(D&& c)
+{
+	return (push_one([&] {
+				return (CBuffer<T, D, E, A>::push(std::move(c))); }));
+}
+
+//! Construct an object from args in place in the buffer.
+template <typename T, typename D, typename E, typename A>
+template <typename... Args>
+bool CBufferM<T, D, E, A>::emplace(Args&&... args)
+{
+	return (push_one([&] {
+				return (CBuffer<T, D, E, A>::emplace(std::forward<Args>(args)...)); }));
+}
+
+/*! add n objects to the buffer.
+ *
+ * @sameas CBuffer::push(const D*, const T)
+ */
+template <typename T, typename D, typename E, typename A>
+T CBufferM<T, D, E, A>::push(const D* data, const T n)
+{
+	const T len { CBuffer<T, D, E, A>::len() };
+	const T free { (T)(CBuffer<T, D, E, A>::size() - len) };
+	// with overwrite() the first objects of data may be dropped too.
+	T skip {0};
+
+	if (CBuffer<T, D, E, A>::overwrite() && (n > free)) {
+		messages_ -= count_front((T)(n - free));
+
+		if (n > CBuffer<T, D, E, A>::size())
+			skip = (T)(n - CBuffer<T, D, E, A>::size());
+	}
+
+	const T j { CBuffer<T, D, E, A>::push(data, n) };
+
+	// j == n with overwrite(), the last n - skip are in.
+	messages_ += (T)std::count(data + skip, data + j, eom_);
+	return (j);
+}
+
+/*! Add n objects written in the reserved slots.
+ *
+ * @sameas CBuffer::publish()
+ */
+template <typename T, typename D, typename E, typename A>
+T CBufferM<T, D, E, A>::publish(const T n)
+{
+	CBufferSegment<T, D> first, second;
+	const T j { CBuffer<T, D, E, A>::reserve(first, second, n) };
+
+	messages_ += (T)(std::count(first.data, first.data + first.len, eom_) +
+			std::count(second.data, second.data + second.len, eom_));
+
+	return (CBuffer<T, D, E, A>::publish(j));
+}
+
+#endif
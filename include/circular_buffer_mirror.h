@@ -0,0 +1,283 @@
+/* Circular Buffer, an object oriented circular buffer (mirrored memory).
+ * Copyright (C) 2015-2021 Enrico Rossi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _CBUFFER_MIRROR_H_
+#define _CBUFFER_MIRROR_H_
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <type_traits>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "circular_buffer_detail.h"
+
+/** Buffer structure
+
+ [ | | | | | | | | | | | | ][ | | | | | | | | | | | | ]
+  ^buffer   ^start            ^size       ^start + len
+            ^--------------- len() -------^
+  ^--------- size ---------^^----- same pages --------^
+
+ The same physical pages are mapped twice back to back (Linux
+ memfd_create() and two MAP_FIXED mmap()), so the objects from
+ start_ are always contiguous in memory, even across the end of
+ the buffer: no segment split or wrap around in bulk operations.
+ The size in bytes must be a multiple of the page size.
+ */
+
+// Mirrored CBuffer of D objects indexed by T type, Linux only.
+template <typename T, typename D>
+class CBufferMirror {
+	static_assert(std::is_trivially_copyable<D>::value,
+			"D must be trivially copyable");
+
+	private:
+		D* buffer_;
+		T start_ { 0 };
+		T len_ { 0 };
+		const T size_;
+		static D* map(const T);
+		T wrap(const size_t i) const { return (T)(i < size_ ? i : i - size_); };
+	public:
+		// debugging methods
+		T size() const { return size_; };
+		bool overflow() const { return (len_ == size_); };
+		T index() const { return wrap((size_t)start_ + len_); };
+		T start() const { return start_; };
+		T operator[](T const i) const { return buffer_[i]; };
+		CBufferMirror(T); // contructor
+		CBufferMirror(const CBufferMirror&) = delete;
+		CBufferMirror& operator=(const CBufferMirror&) = delete;
+		~CBufferMirror();
+		void clear() { start_ = 0; len_ = 0; };
+		T len() const { return len_; };
+		bool popc(D*);
+		T pop(D*, const T);
+		T popm(D*, const T, const D);
+		bool push(D);
+		T push(const D*, const T);
+		// zero-copy, always one contiguous area.
+		T peek(const D**) const;
+		T consume(const T);
+		T reserve(D**, const T);
+		T publish(const T);
+};
+
+/*! Map the memory twice.
+ *
+ * \param sz the number of objects.
+ * \return the beginning of the first mapping.
+ * \throw std::invalid_argument if the size is not a page multiple.
+ * \throw std::system_error if the mapping fails.
+ */
+template <typename T, typename D>
+D* CBufferMirror<T, D>::map(const T sz)
+{
+	const size_t bytes { sizeof(D) * sz };
+	const long page { sysconf(_SC_PAGESIZE) };
+	int fd;
+	void* p;
+	char* addr;
+
+	if ((!bytes) || (bytes % page))
+		throw std::invalid_argument("CBufferMirror: size must be a page multiple");
+
+	fd = memfd_create("cbuffer", MFD_CLOEXEC);
+
+	if (fd < 0)
+		throw std::system_error(errno, std::system_category(), "memfd_create");
+
+	if (ftruncate(fd, bytes)) {
+		const int e { errno };
+		close(fd);
+		throw std::system_error(e, std::system_category(), "ftruncate");
+	}
+
+	// reserve the whole address range, then map the file twice over it.
+	p = mmap(nullptr, 2 * bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	addr = static_cast<char*>(p);
+
+	if ((p == MAP_FAILED) ||
+			(mmap(addr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED,
+			      fd, 0) == MAP_FAILED) ||
+			(mmap(addr + bytes, bytes, PROT_READ | PROT_WRITE,
+			      MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)) {
+		const int e { errno };
+
+		if (p != MAP_FAILED)
+			munmap(p, 2 * bytes);
+
+		close(fd);
+		throw std::system_error(e, std::system_category(), "mmap");
+	}
+
+	// the mappings keep the memory.
+	close(fd);
+	return (reinterpret_cast<D*>(addr));
+}
+
+/*! Initialize the buffer.
+ *
+ * \param sz the number of objects, sz * sizeof(D) must be a
+ * multiple of the page size.
+ */
+template <typename T, typename D>
+CBufferMirror<T, D>::CBufferMirror(T sz) : buffer_ { map(sz) }, size_ { sz }
+{
+}
+
+//! Unmap both the copies.
+template <typename T, typename D>
+CBufferMirror<T, D>::~CBufferMirror()
+{
+	munmap(buffer_, 2 * sizeof(D) * size_);
+}
+
+/*! Extract a single object from the buffer.
+ *
+ * @sameas CBuffer::popc()
+ */
+template <typename T, typename D>
+bool CBufferMirror<T, D>::popc(D *data)
+{
+	if (!len_)
+		return (false);
+
+	*data = buffer_[start_];
+	start_ = wrap((size_t)start_ + 1);
+	len_--;
+	return (true);
+}
+
+/*! Pop everything present in the buffer.
+ *
+ * One memcpy(), @sameas CBuffer::pop()
+ */
+template <typename T, typename D>
+T CBufferMirror<T, D>::pop(D* data, const T sizeofdata)
+{
+	const T n { std::min(len_, sizeofdata) };
+
+	memcpy(data, buffer_ + start_, n * sizeof(D));
+	return (consume(n));
+}
+
+/*! Pop everything from start_ to EOM.
+ *
+ * One search and one memcpy(), @sameas CBuffer::popm()
+ */
+template <typename T, typename D>
+T CBufferMirror<T, D>::popm(D* data, const T sizeofdata, const D eom)
+{
+	const T n { std::min(len_, sizeofdata) };
+	const D* p { cbuffer_find<D>(buffer_ + start_, buffer_ + start_ + n, eom) };
+	const T j { (T)(p - buffer_ - start_) };
+	const T k { (T)(j < n ? j + 1 : n) };
+
+	memcpy(data, buffer_ + start_, k * sizeof(D));
+	consume(k);
+	return (j);
+}
+
+/*! add data to the buffer.
+ *
+ * \return false if the buffer is full.
+ */
+template <typename T, typename D>
+bool CBufferMirror<T, D>::push(D c)
+{
+	if (len_ == size_)
+		return (false);
+
+	buffer_[index()] = c;
+	len_++;
+	return (true);
+}
+
+/*! add n objects to the buffer.
+ *
+ * One memcpy(), @sameas CBuffer::push(const D*, const T)
+ */
+template <typename T, typename D>
+T CBufferMirror<T, D>::push(const D* data, const T n)
+{
+	D* p;
+	const T j { reserve(&p, n) };
+
+	memcpy(p, data, j * sizeof(D));
+	return (publish(j));
+}
+
+/*! Look at the content of the buffer without removing it.
+ *
+ * \param data set to the first object, the following len() objects
+ * are contiguous.
+ * \return len()
+ */
+template <typename T, typename D>
+T CBufferMirror<T, D>::peek(const D** data) const
+{
+	*data = buffer_ + start_;
+	return (len_);
+}
+
+/*! Remove n objects from the buffer.
+ *
+ * \return the number of objects removed.
+ */
+template <typename T, typename D>
+T CBufferMirror<T, D>::consume(const T n)
+{
+	const T j { std::min(len_, n) };
+
+	start_ = wrap((size_t)start_ + j);
+	len_ -= j;
+	return (j);
+}
+
+/*! Reserve free space to be written in place.
+ *
+ * \param data set to the first free slot, the following slots up
+ * to the returned number are contiguous.
+ * \param n the number of slots wanted.
+ * \return the number of slots reserved.
+ */
+template <typename T, typename D>
+T CBufferMirror<T, D>::reserve(D** data, const T n)
+{
+	*data = buffer_ + index();
+	return (std::min<T>(n, (T)(size_ - len_)));
+}
+
+/*! Add n objects written in the reserved slots.
+ *
+ * \return the number of objects added.
+ */
+template <typename T, typename D>
+T CBufferMirror<T, D>::publish(const T n)
+{
+	const T j { std::min<T>(n, (T)(size_ - len_)) };
+
+	len_ += j;
+	return (j);
+}
+
+#endif
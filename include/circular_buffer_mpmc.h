@@ -0,0 +1,210 @@
+/* Circular Buffer, an object oriented circular buffer (bounded MPMC).
+ * Copyright (C) 2015-2021 Enrico Rossi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _CBUFFER_MPMC_H_
+#define _CBUFFER_MPMC_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#ifndef CBUF_SIZE // Default buffer size
+#define CBUF_SIZE 16
+#endif
+
+#ifndef CBUF_CACHE_LINE
+#define CBUF_CACHE_LINE 64
+#endif
+
+/** Buffer structure
+
+ [ | | | | | | | | | | | | | | | | | | | | | | | | ]
+  ^slot[start % size]                ^slot[idx % size]
+            ^------------ len() ----------^
+  ^---------------------- size -------------------^
+
+ idx_ and start_ are free running positions claimed with a CAS.
+ Every slot carries a sequence number which tells who owns it:
+  seq == pos            free, the producer claiming pos may write it.
+  seq == pos + 1        full, the consumer claiming pos may read it.
+ After the read the consumer sets seq = pos + size for the next lap.
+ */
+
+// Bounded multi producer, multi consumer CBuffer of D objects
+// indexed by T type.
+template <typename T, typename D>
+class CBufferMPMC {
+	private:
+		struct slot {
+			std::atomic<size_t> seq;
+			D data;
+		};
+
+		std::unique_ptr<slot[]> buffer_;
+		// producers and consumers on different cache lines.
+		alignas(CBUF_CACHE_LINE) std::atomic<size_t> idx_ { 0 };
+		alignas(CBUF_CACHE_LINE) std::atomic<size_t> start_ { 0 };
+		alignas(CBUF_CACHE_LINE) const T size_;
+	public:
+		T size() const { return size_; };
+		CBufferMPMC(T = CBUF_SIZE); // contructor
+		CBufferMPMC(const CBufferMPMC&) = delete;
+		CBufferMPMC& operator=(const CBufferMPMC&) = delete;
+		void clear();
+		T len() const;
+		bool popc(D*);
+		T pop(D*, const T);
+		bool push(D);
+};
+
+/*! Initialize the buffer.
+ *
+ * \param sz the number of objects the buffer can hold.
+ */
+template <typename T, typename D>
+CBufferMPMC<T, D>::CBufferMPMC(T sz) :
+	buffer_ { std::make_unique<slot[]>(sz) }, size_ { sz }
+{
+	clear();
+}
+
+/*! Clear the buffer.
+ *
+ * \warning not thread-safe, no producer or consumer must be running.
+ */
+template <typename T, typename D>
+void CBufferMPMC<T, D>::clear()
+{
+	for (size_t i = 0; i < size_; i++)
+		buffer_[i].seq.store(i, std::memory_order_relaxed);
+
+	idx_.store(0, std::memory_order_relaxed);
+	start_.store(0, std::memory_order_relaxed);
+}
+
+/** LENght of the buffer
+ *
+ * @return len
+ * @note it is a snapshot, it can be already changed when returned.
+ */
+template <typename T, typename D>
+T CBufferMPMC<T, D>::len() const
+{
+	const size_t s { start_.load(std::memory_order_relaxed) };
+	const size_t i { idx_.load(std::memory_order_relaxed) };
+
+	// a producer may have claimed a slot not yet popped from a
+	// start_ read before.
+	if (i > s)
+		return ((i - s) > size_ ? size_ : (T)(i - s));
+	else
+		return (0);
+}
+
+/*! Extract a single object from the buffer.
+ *
+ * \param data the area where to copy the object.
+ * \return true if ok, false if the buffer is empty.
+ */
+template <typename T, typename D>
+bool CBufferMPMC<T, D>::popc(D *data)
+{
+	size_t pos { start_.load(std::memory_order_relaxed) };
+	slot* s;
+
+	while (true) {
+		s = &buffer_[pos % size_];
+		const size_t seq { s->seq.load(std::memory_order_acquire) };
+		const intptr_t dif { (intptr_t)seq - (intptr_t)(pos + 1) };
+
+		if (dif == 0) {
+			// the slot is full, try to claim it.
+			if (start_.compare_exchange_weak(pos, pos + 1,
+						std::memory_order_relaxed))
+				break;
+		} else if (dif < 0) {
+			// the producer of this lap did not write it: empty.
+			return (false);
+		} else {
+			// another consumer took it, retry from the new start.
+			pos = start_.load(std::memory_order_relaxed);
+		}
+	}
+
+	*data = s->data;
+	// release the slot to the producer of the next lap.
+	s->seq.store(pos + size_, std::memory_order_release);
+	return (true);
+}
+
+/*! Pop everything present in the buffer.
+ *
+ * \param data the area where to copy the objects.
+ * \param sizeofdata.
+ * \return the number of objects fetched.
+ * \note with other consumers running the objects fetched are not
+ * guaranteed to be contiguous in the stream.
+ */
+template <typename T, typename D>
+T CBufferMPMC<T, D>::pop(D* data, const T sizeofdata)
+{
+	T j {0};
+
+	while ((j < sizeofdata) && popc(data + j))
+		j++;
+
+	return (j);
+}
+
+/*! add data to the buffer.
+ *
+ * \return false if the buffer is full.
+ */
+template <typename T, typename D>
+bool CBufferMPMC<T, D>::push(D c)
+{
+	size_t pos { idx_.load(std::memory_order_relaxed) };
+	slot* s;
+
+	while (true) {
+		s = &buffer_[pos % size_];
+		const size_t seq { s->seq.load(std::memory_order_acquire) };
+		const intptr_t dif { (intptr_t)seq - (intptr_t)pos };
+
+		if (dif == 0) {
+			// the slot is free, try to claim it.
+			if (idx_.compare_exchange_weak(pos, pos + 1,
+						std::memory_order_relaxed))
+				break;
+		} else if (dif < 0) {
+			// the consumer of the previous lap did not read it: full.
+			return (false);
+		} else {
+			// another producer took it, retry from the new index.
+			pos = idx_.load(std::memory_order_relaxed);
+		}
+	}
+
+	s->data = c;
+	// publish the object to the consumers.
+	s->seq.store(pos + 1, std::memory_order_release);
+	return (true);
+}
+
+#endif
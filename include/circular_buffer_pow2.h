@@ -0,0 +1,192 @@
+/* Circular Buffer, an object oriented circular buffer (power of two size).
+ * Copyright (C) 2015-2021 Enrico Rossi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _CBUFFER_POW2_H_
+#define _CBUFFER_POW2_H_
+
+#include <algorithm>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include "circular_buffer_detail.h"
+
+#ifndef CBUF_SIZE // Default buffer size
+#define CBUF_SIZE 16
+#endif
+
+/** Buffer structure
+
+ [ | | | | | | | | | | | | | | | | | | | | | | | | ]
+  ^buffer   ^start & MASK                 ^idx & MASK
+            ^------- len() = idx - start -^
+  ^------------------ size = 2^n -----------------^
+
+ idx_ and start_ are free running counters which wrap around at
+ the end of the type T, the slot is the counter & MASK_.
+ The size must be a power of two and less or equal to half the
+ range of T, then len() is always idx_ - start_ and a full buffer
+ is told apart from an empty one with no overflow flag.
+ */
+
+// CBuffer of D objects indexed by T type, power of two size.
+// Same API of CBuffer<T, D>.
+template <typename T, typename D>
+class CBufferPow2 {
+	static_assert(std::is_unsigned<T>::value, "T must be unsigned");
+
+	private:
+		std::unique_ptr<D[]> buffer_;
+		T idx_ { 0 };
+		T start_ { 0 };
+		static T check(T);
+	protected:
+		const T size_;
+		const T MASK_;
+	public:
+		// debugging methods
+		T size() const { return size_; };
+		bool overflow() const { return (len() == size_); };
+		T index() const { return (idx_ & MASK_); };
+		T start() const { return (start_ & MASK_); };
+		// FIXME i < size_
+		T operator[](T const i) const { return buffer_[i]; };
+		CBufferPow2(T = CBUF_SIZE); // contructor
+		void clear() { idx_ = 0; start_ = 0; };
+		T len() const { return ((T)(idx_ - start_)); };
+		bool popc(D*);
+		T pop(D*, const T);
+		T popm(D*, const T, const D);
+		bool push(D);
+		T push(const D*, const T);
+};
+
+/*! Check the size.
+ *
+ * \return the size if it is a power of two and it fits.
+ * \throw std::invalid_argument otherwise.
+ */
+template <typename T, typename D>
+T CBufferPow2<T, D>::check(T sz)
+{
+	if ((!sz) || (sz & (sz - 1)) || (sz > (std::numeric_limits<T>::max() / 2 + 1)))
+		throw std::invalid_argument("CBufferPow2: size must be a power of two");
+
+	return (sz);
+}
+
+/*! Initialize the buffer.
+ *
+ * \param sz the size, a power of two.
+ */
+template <typename T, typename D>
+CBufferPow2<T, D>::CBufferPow2(T sz) :
+	buffer_ { std::make_unique<D[]>(check(sz)) },
+	size_ { sz }, MASK_ { (T)(sz - 1) }
+{
+}
+
+/*! Extract a single object from the buffer.
+ *
+ * \param data the area where to copy the object.
+ * \return true if ok
+ */
+template <typename T, typename D>
+bool CBufferPow2<T, D>::popc(D *data)
+{
+	if (idx_ == start_)
+		return (false);
+
+	*data = buffer_[start_ & MASK_];
+	start_++;
+	return (true);
+}
+
+/*! Pop everything present in the buffer.
+ *
+ * @sameas CBuffer::pop()
+ */
+template <typename T, typename D>
+T CBufferPow2<T, D>::pop(D* data, const T sizeofdata)
+{
+	const T n { std::min(len(), sizeofdata) };
+	const T s { start() };
+	const T first { std::min<T>(n, (T)(size_ - s)) };
+
+	cbuffer_copy(data, buffer_.get() + s, first);
+
+	if (n > first)
+		cbuffer_copy(data + first, buffer_.get(), n - first);
+
+	start_ += n;
+	return (n);
+}
+
+/*! Pop everything from start_ to EOM.
+ *
+ * The EOM is searched first, then the message is copied in bulk.
+ *
+ * @sameas CBuffer::popm()
+ */
+template <typename T, typename D>
+T CBufferPow2<T, D>::popm(D* data, const T sizeofdata, const D eom)
+{
+	const T n { std::min(len(), sizeofdata) };
+	const T j { cbuffer_find_eom<T, D>(buffer_.get(), size_, start(), n, eom) };
+
+	// the EOM is removed and copied too.
+	pop(data, (T)(j < n ? j + 1 : n));
+	return (j);
+}
+
+/*! add data to the buffer.
+ *
+ * \return false if the buffer is full.
+ */
+template <typename T, typename D>
+bool CBufferPow2<T, D>::push(D c)
+{
+	if (len() == size_)
+		return (false);
+
+	buffer_[idx_ & MASK_] = c;
+	idx_++;
+	return (true);
+}
+
+/*! add n objects to the buffer.
+ *
+ * @sameas CBuffer::push(const D*, const T)
+ */
+template <typename T, typename D>
+T CBufferPow2<T, D>::push(const D* data, const T n)
+{
+	const T j { std::min<T>(n, (T)(size_ - len())) };
+	const T i { index() };
+	const T first { std::min<T>(j, (T)(size_ - i)) };
+
+	cbuffer_copy(buffer_.get() + i, data, first);
+
+	if (j > first)
+		cbuffer_copy(buffer_.get(), data + first, j - first);
+
+	idx_ += j;
+	return (j);
+}
+
+#endif
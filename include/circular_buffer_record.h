@@ -0,0 +1,165 @@
+/* Circular Buffer, an object oriented circular buffer (records).
+ * Copyright (C) 2015-2021 Enrico Rossi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _CBUFFER_RECORD_H_
+#define _CBUFFER_RECORD_H_
+
+#include <cstdint>
+#include "circular_buffer.h"
+
+/** Buffer structure
+
+ [ | | | | | | | | | | | | | | | | | | | | | | | | ]
+  ^buffer   ^start                        ^idx    ^TOP
+            [h|record 0 ][h h|record 1   ]
+  ^---------------------- size -------------------^
+
+ A record is a length header and the bytes. The length is a varint
+ (LEB128): 7 bits per byte, the high bit set on all bytes but the
+ last, so records shorter than 128 bytes have a 1 byte header.
+ Records are pushed and popped whole, the buffer never holds part
+ of a record, no byte is scanned and the payload can hold any value.
+
+ \warning do not mix with the byte push() and pop() of CBuffer.
+ */
+
+// CBuffer of bytes indexed by T type, holding whole records.
+template <typename T>
+class CBufferR : public CBuffer<T, uint8_t> {
+	private:
+		// max header bytes for a T length.
+		static const unsigned int HDR_MAX { (sizeof(T) * 8 + 6) / 7 };
+		unsigned int header(T*) const;
+	public:
+		CBufferR(T = CBUF_SIZE); // contructor
+		static unsigned int header_len(T);
+		bool peekr(T*) const;
+		bool pushr(const uint8_t*, const T);
+		bool popr(uint8_t*, const T, T*);
+};
+
+//! Contruct the buffer.
+template <typename T>
+CBufferR<T>::CBufferR(T size) : CBuffer<T, uint8_t>{size}
+{
+}
+
+/*! Bytes of the header for a record of n bytes.
+ *
+ * \param n the record length.
+ * \return 1 to HDR_MAX.
+ */
+template <typename T>
+unsigned int CBufferR<T>::header_len(T n)
+{
+	unsigned int i {1};
+
+	while (n >>= 7)
+		i++;
+
+	return (i);
+}
+
+/*! Decode the header of the first record in place.
+ *
+ * \param n set to the record length.
+ * \return the bytes of the header, 0 if there is no record.
+ */
+template <typename T>
+unsigned int CBufferR<T>::header(T* n) const
+{
+	CBufferSegment<T, const uint8_t> first, second;
+	const T len { CBuffer<T, uint8_t>::peek(first, second) };
+	uint8_t c;
+	unsigned int i {0};
+
+	*n = 0;
+
+	do {
+		if ((i >= len) || (i >= HDR_MAX))
+			return (0);
+
+		c = i < first.len ? first.data[i] : second.data[i - first.len];
+		*n |= (T)((T)(c & 0x7f) << (7 * i));
+		i++;
+	} while (c & 0x80);
+
+	return (i);
+}
+
+/*! Length of the first record.
+ *
+ * \param n set to the record length.
+ * \return false if the buffer is empty.
+ */
+template <typename T>
+bool CBufferR<T>::peekr(T* n) const
+{
+	return (header(n) != 0);
+}
+
+/*! Add a record.
+ *
+ * The header and the bytes are pushed only if all of them fit.
+ *
+ * \param data the record.
+ * \param n the record length.
+ * \return false if the record does not fit, nothing is pushed.
+ */
+template <typename T>
+bool CBufferR<T>::pushr(const uint8_t* data, const T n)
+{
+	uint8_t hdr[HDR_MAX];
+	const unsigned int h { header_len(n) };
+	T len { n };
+
+	if ((size_t)h + n > (size_t)(CBuffer<T, uint8_t>::size() - CBuffer<T, uint8_t>::len()))
+		return (false);
+
+	for (unsigned int i = 0; i < h; i++) {
+		hdr[i] = (uint8_t)((len & 0x7f) | (i + 1 < h ? 0x80 : 0));
+		len >>= 7;
+	}
+
+	CBuffer<T, uint8_t>::push(hdr, (T)h);
+	CBuffer<T, uint8_t>::push(data, n);
+	return (true);
+}
+
+/*! Extract a record.
+ *
+ * \param data the area where to copy the record.
+ * \param sizeofdata the size of data.
+ * \param n set to the record length, also when it does not fit.
+ * \return false if there is no record or data is too small, the
+ * record stays in the buffer.
+ */
+template <typename T>
+bool CBufferR<T>::popr(uint8_t* data, const T sizeofdata, T* n)
+{
+	const unsigned int h { header(n) };
+
+	if ((!h) || (*n > sizeofdata))
+		return (false);
+
+	CBuffer<T, uint8_t>::consume((T)h);
+	CBuffer<T, uint8_t>::pop(data, *n);
+	return (true);
+}
+
+#endif
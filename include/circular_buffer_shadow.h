@@ -29,28 +29,39 @@
                       ^ -- shadow_len() --^
             ^------------ len() ----------^
   ^---------------------- size -------------------^
+
+ read_ objects between start and shadow_start are read and not
+ committed yet. With overwrite() a push may drop some of them, the
+ shadow index is then moved to the new start.
  */
 
-template <typename T, typename D>
-class CBufferS : public CBuffer<T, D> {
+template <typename T, typename D, typename E = CBufferObject<D>,
+				 typename A = std::allocator<D>>
+class CBufferS : public CBuffer<T, D, E, A> {
 	private:
-		T shadow_start_;
+		T shadow_start_ { 0 };
+		T read_ { 0 };
+		void drop_shadow(const size_t);
 	public:
 		// Debugging methods
 		T start() const { return(shadow_start_); };
-		T len() const override;
+		T len() const;
 
 		// Contructor
 		// force the Base constructor with the parameter size
 		// or it will call the default with no parameters and
 		// it will throw and error if initialiazed with one.
-		CBufferS(T = CBUF_SIZE);
+		CBufferS(T = CBUF_SIZE, const A& = A());
 
 		// declaration overload for shadow index.
-		void clear() override;
+		void clear();
 		bool popc(D*);
 		T pop(D*, const T);
-		bool push(D);
+		bool push(const D&);
+		bool push(D&&);
+		template <typename... Args>
+		bool emplace(Args&&...);
+		T push(const D*, const T);
 
 		// new member functions
 		void commit();
@@ -61,11 +72,12 @@ class CBufferS : public CBuffer<T, D> {
  *
  * @sameas CBuffer::clear()
  */
-template <typename T, typename D>
-void CBufferS<T, D>::clear()
+template <typename T, typename D, typename E, typename A>
+void CBufferS<T, D, E, A>::clear()
 {
-	CBuffer<T, D>::clear(); // call the base clear
+	CBuffer<T, D, E, A>::clear(); // call the base clear
 	shadow_start_ = 0;
+	read_ = 0;
 }
 
 /** LENght of the buffer
@@ -77,24 +89,16 @@ void CBufferS<T, D>::clear()
  * @note const function does not change any attribute.
  * @sameas CBuffer::len()
  */
-template <typename T, typename D>
-T CBufferS<T, D>::len() const
+template <typename T, typename D, typename E, typename A>
+T CBufferS<T, D, E, A>::len() const
 {
-  if (shadow_start_ == CBufferS<T, D>::index()) {
-    if (CBufferS<T, D>::overflow())
-      return CBufferS<T, D>::size();
-    else
-      return 0;
-  } else if (CBuffer<T, D>::index() > shadow_start_) {
-    return (CBuffer<T, D>::index() - shadow_start_);
-  } else {
-    return (CBuffer<T, D>::size() - shadow_start_ + CBuffer<T, D>::index());
-  }
+	return (CBuffer<T, D, E, A>::len() - read_);
 }
 
 //! Contruct the buffer with the shadow index.
-template <typename T, typename D>
-CBufferS<T, D>::CBufferS(T size) : CBuffer<T, D>{size}
+template <typename T, typename D, typename E, typename A>
+CBufferS<T, D, E, A>::CBufferS(T size, const A& alloc) :
+	CBuffer<T, D, E, A>{size, alloc}
 {
   clear();
 }
@@ -103,21 +107,21 @@ CBufferS<T, D>::CBufferS(T size) : CBuffer<T, D>{size}
  *
  * \warning possible race condition!
  */
-template <typename T, typename D>
-bool CBufferS<T, D>::popc(D *data)
+template <typename T, typename D, typename E, typename A>
+bool CBufferS<T, D, E, A>::popc(D *data)
 {
 	if (len()) {
-		// Here "this->" could be used since operator[] has not
-		// been overloaded.
-		*data = CBuffer<T, D>::operator[](shadow_start_);
+		// copy, the object stays in the buffer until commit().
+		CBuffer<T, D, E, A>::copy_out(data, shadow_start_, 1);
 
 		// Here "this->" could be used since TOP_ has not
 		// been overloaded.
-		if (shadow_start_ == CBuffer<T, D>::TOP_)
+		if (shadow_start_ == CBuffer<T, D, E, A>::TOP_)
 			shadow_start_ = 0;
 		else
 			shadow_start_++;
 
+		read_++;
 		return (true);
 	} else {
 		return (false);
@@ -125,57 +129,112 @@ bool CBufferS<T, D>::popc(D *data)
 }
 
 /*! Pop a copy of everything present in the buffer.
+ *
+ * Bulk copy from the shadow index, see CBuffer::pop().
  *
  * \warning if the data size is less than the buffer, only the sizeofdata
  * byte get fetched, the buffer remain not empty.
  */
-template <typename T, typename D>
-T CBufferS<T, D>::pop(D* data, const T sizeofdata)
+template <typename T, typename D, typename E, typename A>
+T CBufferS<T, D, E, A>::pop(D* data, const T sizeofdata)
 {
-	T j {0};
+	const T n { len() < sizeofdata ? len() : sizeofdata };
 
-	// while there is space left on data and byte in the buffer
-	while ((j < sizeofdata) && popc(data + j))
-		j++;
+	if (n) {
+		CBuffer<T, D, E, A>::copy_out(data, shadow_start_, n);
+		shadow_start_ = CBuffer<T, D, E, A>::wrap((size_t)shadow_start_ + n);
+		read_ += n;
+	}
 
-	return (j);
+	return (n);
 }
 
-/*! add data to the buffer and update the shadow indexes.
+/*! Move the shadow index past the objects dropped by a push.
  *
- * \warning race condition with other functions.
- *  modified CBufferS members data: shadow_len_
+ * \param n the objects dropped from the start of the buffer.
  */
-template <typename T, typename D>
-bool CBufferS<T, D>::push(D c)
+template <typename T, typename D, typename E, typename A>
+void CBufferS<T, D, E, A>::drop_shadow(const size_t n)
 {
-	if (CBuffer<T, D>::push(c)) {
-		return(true);
+	if (n >= read_) {
+		read_ = 0;
+		shadow_start_ = CBuffer<T, D, E, A>::start();
 	} else {
-		return(false);
+		read_ -= n;
 	}
 }
 
+/*! add data to the buffer and update the shadow indexes.
+ *
+ * \warning race condition with other functions.
+ *  modified CBufferS members data: shadow_start_, read_
+ */
+template <typename T, typename D, typename E, typename A>
+bool CBufferS<T, D, E, A>::push(const D& c)
+{
+	const size_t dropped { CBuffer<T, D, E, A>::dropped() };
+	const bool ok { CBuffer<T, D, E, A>::push(c) };
+
+	drop_shadow(CBuffer<T, D, E, A>::dropped() - dropped);
+	return (ok);
+}
+
+//! move the object into the buffer.
+template <typename T, typename D, typename E, typename A>
+bool CBufferS<T, D, E, A>::push(D&& c)
+{
+	const size_t dropped { CBuffer<T, D, E, A>::dropped() };
+	const bool ok { CBuffer<T, D, E, A>::push(std::move(c)) };
+
+	drop_shadow(CBuffer<T, D, E, A>::dropped() - dropped);
+	return (ok);
+}
+
+//! Construct an object from args in place in the buffer.
+template <typename T, typename D, typename E, typename A>
+template <typename... Args>
+bool CBufferS<T, D, E, A>::emplace(Args&&... args)
+{
+	const size_t dropped { CBuffer<T, D, E, A>::dropped() };
+	const bool ok { CBuffer<T, D, E, A>::emplace(std::forward<Args>(args)...) };
+
+	drop_shadow(CBuffer<T, D, E, A>::dropped() - dropped);
+	return (ok);
+}
+
+/*! add n objects to the buffer.
+ *
+ * @sameas CBuffer::push(const D*, const T)
+ */
+template <typename T, typename D, typename E, typename A>
+T CBufferS<T, D, E, A>::push(const D* data, const T n)
+{
+	const size_t dropped { CBuffer<T, D, E, A>::dropped() };
+	const T j { CBuffer<T, D, E, A>::push(data, n) };
+
+	drop_shadow(CBuffer<T, D, E, A>::dropped() - dropped);
+	return (j);
+}
+
 /*! Commit the shadow index operations.
  *
- * Uses the protected CBuffer member functions.
+ * The objects read are removed, and destroyed, with consume().
  */
-template <typename T, typename D>
-void CBufferS<T, D>::commit()
+template <typename T, typename D, typename E, typename A>
+void CBufferS<T, D, E, A>::commit()
 {
-  if (CBuffer<T, D>::start() != shadow_start_) {
-    CBuffer<T, D>::set_start(shadow_start_);
-    CBuffer<T, D>::clear_overflow();
-  }
+	CBuffer<T, D, E, A>::consume(read_);
+	read_ = 0;
 }
 
 /*! Restore the index back.
  *
  */
-template <typename T, typename D>
-void CBufferS<T, D>::reset()
+template <typename T, typename D, typename E, typename A>
+void CBufferS<T, D, E, A>::reset()
 {
-	shadow_start_ = CBuffer<T, D>::start();
+	shadow_start_ = CBuffer<T, D, E, A>::start();
+	read_ = 0;
 }
 
 #endif
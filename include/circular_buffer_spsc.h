@@ -0,0 +1,400 @@
+/* Circular Buffer, an object oriented circular buffer (lock-free SPSC).
+ * Copyright (C) 2015-2021 Enrico Rossi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _CBUFFER_SPSC_H_
+#define _CBUFFER_SPSC_H_
+
+#include <atomic>
+#include <cstddef>
+#include <chrono>
+#include <memory>
+#include "circular_buffer.h"
+#include "circular_buffer_wait.h"
+
+#ifndef CBUF_SIZE // Default buffer size
+#define CBUF_SIZE 16
+#endif
+
+#ifndef CBUF_CACHE_LINE
+#define CBUF_CACHE_LINE 64
+#endif
+
+/** Buffer structure
+
+ [ | | | | | | | | | | | | | | | | | | | | | | | | |#]
+  ^buffer   ^start                        ^idx       ^TOP
+            ^------------ len() ----------^
+  ^---------------------- size -------------------^
+
+ One spare slot (#) is allocated, so full and empty can be told
+ apart by the indexes only: no shared overflow flag.
+ idx_ is written by the producer only, start_ by the consumer only.
+ Each one sits on its own cache line together with the private copy
+ of the other index the owner last read. The copy is refreshed only
+ when the buffer looks full (producer) or empty (consumer), so in the
+ steady state the two sides do not touch each other's line.
+ */
+
+// Lock-free single producer, single consumer CBuffer of D objects
+// indexed by T type, W is how the *_wait() members wait.
+template <typename T, typename D, typename W = CBufferWaitSpin>
+class CBufferSPSC {
+	protected:
+		std::unique_ptr<D[]> buffer_;
+		const T size_;
+		const T TOP_;
+		// producer cache line, start_cache_ is the last start_ seen.
+		alignas(CBUF_CACHE_LINE) std::atomic<T> idx_ { 0 };
+		T start_cache_ { 0 };
+		// consumer cache line, idx_cache_ is the last idx_ seen.
+		alignas(CBUF_CACHE_LINE) std::atomic<T> start_ { 0 };
+		T idx_cache_ { 0 };
+		// the consumer waits on not_empty_, the producer on not_full_.
+		alignas(CBUF_CACHE_LINE) W not_empty_ {};
+		alignas(CBUF_CACHE_LINE) W not_full_ {};
+		T available(T, T);
+		T next(T i) const { return (i == TOP_ ? 0 : (T)(i + 1)); };
+		T advance(T i, T n) const {
+			return ((T)((size_t)i + n > TOP_ ? (size_t)i + n - TOP_ - 1 : i + n)); };
+		T distance(T, T) const;
+	private:
+		T free(T);
+	public:
+		// debugging methods
+		T size() const { return size_; };
+		bool overflow() const { return (len() == size_); };
+		T index() const { return idx_.load(std::memory_order_relaxed); };
+		T start() const { return start_.load(std::memory_order_relaxed); };
+		CBufferSPSC(T = CBUF_SIZE); // contructor
+		CBufferSPSC(const CBufferSPSC&) = delete;
+		CBufferSPSC& operator=(const CBufferSPSC&) = delete;
+		void clear();
+		T len() const;
+		// consumer side
+		bool popc(D*);
+		T pop(D*, const T);
+		T popm(D*, const T, const D);
+		template <typename Rep, typename Period>
+		bool popc_wait(D*, const std::chrono::duration<Rep, Period>&);
+		template <typename Rep, typename Period>
+		T pop_wait(D*, const T, const std::chrono::duration<Rep, Period>&);
+		// producer side
+		bool push(D);
+		template <typename Rep, typename Period>
+		bool push_wait(D, const std::chrono::duration<Rep, Period>&);
+		T reserve(CBufferSegment<T, D>&, CBufferSegment<T, D>&, const T);
+		T publish(const T);
+};
+
+//! Number of objects between start s and index i.
+template <typename T, typename D, typename W>
+T CBufferSPSC<T, D, W>::distance(T s, T i) const
+{
+	if (i >= s)
+		return (i - s);
+	else
+		return (TOP_ + 1 - s + i);
+}
+
+/*! Free slots seen by the producer.
+ *
+ * start_ is loaded only if the cached copy does not leave room
+ * for n objects.
+ */
+template <typename T, typename D, typename W>
+T CBufferSPSC<T, D, W>::free(T n)
+{
+	const T i { idx_.load(std::memory_order_relaxed) };
+	T f { (T)(size_ - distance(start_cache_, i)) };
+
+	if (f < n) {
+		// acquire: the slots freed by the consumer are no longer read.
+		start_cache_ = start_.load(std::memory_order_acquire);
+		f = (T)(size_ - distance(start_cache_, i));
+	}
+
+	return (f);
+}
+
+/*! Objects from s seen by the consumer.
+ *
+ * idx_ is loaded only if the cached copy shows less than n objects.
+ */
+template <typename T, typename D, typename W>
+T CBufferSPSC<T, D, W>::available(T s, T n)
+{
+	T a { distance(s, idx_cache_) };
+
+	if (a < n) {
+		// acquire: the objects before idx_ are visible.
+		idx_cache_ = idx_.load(std::memory_order_acquire);
+		a = distance(s, idx_cache_);
+	}
+
+	return (a);
+}
+
+/*! Initialize the buffer.
+ *
+ * \param sz the number of objects the buffer can hold.
+ */
+template <typename T, typename D, typename W>
+CBufferSPSC<T, D, W>::CBufferSPSC(T sz) :
+	buffer_ { std::make_unique<D[]>((size_t)sz + 1) },
+	size_ { sz }, TOP_ { sz }
+{
+}
+
+/*! Clear the buffer.
+ *
+ * \warning not thread-safe, no producer or consumer must be running.
+ */
+template <typename T, typename D, typename W>
+void CBufferSPSC<T, D, W>::clear()
+{
+	idx_.store(0, std::memory_order_relaxed);
+	start_.store(0, std::memory_order_relaxed);
+	start_cache_ = 0;
+	idx_cache_ = 0;
+}
+
+/** LENght of the buffer
+ *
+ * @return len
+ * @note with the other side running it is a snapshot, from the
+ * consumer it is the minimum available, from the producer the maximum.
+ */
+template <typename T, typename D, typename W>
+T CBufferSPSC<T, D, W>::len() const
+{
+	return (distance(start_.load(std::memory_order_acquire),
+				idx_.load(std::memory_order_acquire)));
+}
+
+/*! Extract a single object from the buffer.
+ *
+ * Consumer only.
+ *
+ * \param data the area where to copy the object.
+ * \return true if ok
+ */
+template <typename T, typename D, typename W>
+bool CBufferSPSC<T, D, W>::popc(D *data)
+{
+	const T s { start_.load(std::memory_order_relaxed) };
+
+	if (!available(s, 1))
+		return (false);
+
+	*data = buffer_[s];
+	// release: the slot is free for the producer only after the copy.
+	start_.store(next(s), std::memory_order_release);
+	not_full_.notify();
+	return (true);
+}
+
+/*! Pop everything present in the buffer.
+ *
+ * Consumer only. The index of the producer is read at most once
+ * and start_ is published once at the end.
+ *
+ * \param data the area where to copy the objects.
+ * \param sizeofdata.
+ * \return the number of objects fetched.
+ */
+template <typename T, typename D, typename W>
+T CBufferSPSC<T, D, W>::pop(D* data, const T sizeofdata)
+{
+	T s { start_.load(std::memory_order_relaxed) };
+	const T a { available(s, sizeofdata) };
+	T j {0};
+
+	while ((j < sizeofdata) && (j < a)) {
+		*(data + j) = buffer_[s];
+		s = next(s);
+		j++;
+	}
+
+	if (j) {
+		start_.store(s, std::memory_order_release);
+		not_full_.notify();
+	}
+
+	return (j);
+}
+
+/*! Pop everything from start_ to EOM.
+ *
+ * Consumer only, same behaviour as CBuffer::popm().
+ *
+ * \note EOM is NOT counted but it is copied and removed.
+ */
+template <typename T, typename D, typename W>
+T CBufferSPSC<T, D, W>::popm(D* data, const T sizeofdata, const D eom)
+{
+	T s { start_.load(std::memory_order_relaxed) };
+	const T a { available(s, sizeofdata) };
+	T j {0};
+
+	while ((j < sizeofdata) && (j < a)) {
+		*(data + j) = buffer_[s];
+		s = next(s);
+
+		if (*(data + j) == eom)
+			break;
+
+		j++;
+	}
+
+	if (s != start_.load(std::memory_order_relaxed)) {
+		start_.store(s, std::memory_order_release);
+		not_full_.notify();
+	}
+
+	return (j);
+}
+
+/*! add data to the buffer.
+ *
+ * Producer only.
+ *
+ * \return false if the buffer is full.
+ */
+template <typename T, typename D, typename W>
+bool CBufferSPSC<T, D, W>::push(D c)
+{
+	const T i { idx_.load(std::memory_order_relaxed) };
+
+	if (!free(1))
+		return (false);
+
+	buffer_[i] = c;
+	// release: the object is written before it becomes visible.
+	idx_.store(next(i), std::memory_order_release);
+	not_empty_.notify();
+	return (true);
+}
+
+/*! Reserve free space to be written in place.
+ *
+ * Producer only, @sameas CBuffer::reserve()
+ */
+template <typename T, typename D, typename W>
+T CBufferSPSC<T, D, W>::reserve(CBufferSegment<T, D>& first,
+		CBufferSegment<T, D>& second, const T n)
+{
+	const T i { idx_.load(std::memory_order_relaxed) };
+	const T f { free(n) };
+	const T j { n < f ? n : f };
+	const T top { (T)(TOP_ - i + 1) };
+
+	first.data = buffer_.get() + i;
+	first.len = j < top ? j : top;
+	second.data = buffer_.get();
+	second.len = j - first.len;
+
+	return (j);
+}
+
+/*! Add n objects written in the reserved slots.
+ *
+ * Producer only, the whole batch becomes visible to the consumer
+ * at once with a single release store of idx_.
+ *
+ * \return the number of objects added, capped to the free space.
+ */
+template <typename T, typename D, typename W>
+T CBufferSPSC<T, D, W>::publish(const T n)
+{
+	const T i { idx_.load(std::memory_order_relaxed) };
+	const T f { free(n) };
+	const T j { n < f ? n : f };
+
+	if (j) {
+		idx_.store(advance(i, j), std::memory_order_release);
+		not_empty_.notify();
+	}
+
+	return (j);
+}
+
+/*! Extract a single object, wait if the buffer is empty.
+ *
+ * Consumer only, @sameas popc()
+ *
+ * \param timeout the maximum time to wait.
+ * \return false if still empty after the timeout.
+ */
+template <typename T, typename D, typename W>
+template <typename Rep, typename Period>
+bool CBufferSPSC<T, D, W>::popc_wait(D* data,
+		const std::chrono::duration<Rep, Period>& timeout)
+{
+	if (popc(data))
+		return (true);
+
+	return (not_empty_.wait([this] {
+				return (available(start_.load(std::memory_order_relaxed), 1) != 0); },
+				CBufferClock::now() + timeout) && popc(data));
+}
+
+/*! Pop everything present, wait if the buffer is empty.
+ *
+ * Consumer only, @sameas pop()
+ *
+ * \param timeout the maximum time to wait for the first object.
+ * \return the number of objects fetched, 0 after the timeout.
+ */
+template <typename T, typename D, typename W>
+template <typename Rep, typename Period>
+T CBufferSPSC<T, D, W>::pop_wait(D* data, const T sizeofdata,
+		const std::chrono::duration<Rep, Period>& timeout)
+{
+	const T j { pop(data, sizeofdata) };
+
+	if (j || !sizeofdata)
+		return (j);
+
+	if (!not_empty_.wait([this] {
+				return (available(start_.load(std::memory_order_relaxed), 1) != 0); },
+				CBufferClock::now() + timeout))
+		return (0);
+
+	return (pop(data, sizeofdata));
+}
+
+/*! add data to the buffer, wait if the buffer is full.
+ *
+ * Producer only, @sameas push()
+ *
+ * \param timeout the maximum time to wait.
+ * \return false if still full after the timeout.
+ */
+template <typename T, typename D, typename W>
+template <typename Rep, typename Period>
+bool CBufferSPSC<T, D, W>::push_wait(D c,
+		const std::chrono::duration<Rep, Period>& timeout)
+{
+	if (push(c))
+		return (true);
+
+	return (not_full_.wait([this] { return (free(1) != 0); },
+				CBufferClock::now() + timeout) && push(c));
+}
+
+#endif
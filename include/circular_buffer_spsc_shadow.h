@@ -0,0 +1,236 @@
+/* Circular Buffer, an object oriented circular buffer (lock-free SPSC
+ * with a transactional consumer).
+ * Copyright (C) 2015-2021 Enrico Rossi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _CBUFFER_SPSC_SHADOW_H_
+#define _CBUFFER_SPSC_SHADOW_H_
+
+#include "circular_buffer_spsc.h"
+
+/** Buffer structure
+
+ [ | | | | | | | | | | | | | | | | | | | | | | | | |#]
+  ^buffer   ^start    ^shadow_start       ^idx       ^TOP
+                      ^---- len() --------^
+  ^---------------------- size -------------------^
+
+ Same as CBufferS, but on top of CBufferSPSC: the producer may push
+ while the consumer reads, processes and then commits or rolls back.
+ shadow_start_ is private to the consumer, the producer sees only
+ start_, so the objects read and not yet committed are never
+ overwritten. commit() is a single release store of start_.
+ All the consumer reads, the *_wait() ones and popm() too, move the
+ shadow index only.
+ */
+
+// Lock-free SPSC CBuffer with the shadow index of CBufferS.
+template <typename T, typename D, typename W = CBufferWaitSpin>
+class CBufferSPSCS : public CBufferSPSC<T, D, W> {
+	private:
+		T shadow_start_ { 0 };
+	public:
+		// Debugging methods
+		T start() const { return (shadow_start_); };
+		T len() const;
+		CBufferSPSCS(T = CBUF_SIZE); // contructor
+
+		// consumer side, with the shadow index.
+		void clear();
+		bool popc(D*);
+		T pop(D*, const T);
+		T popm(D*, const T, const D);
+		template <typename Rep, typename Period>
+		bool popc_wait(D*, const std::chrono::duration<Rep, Period>&);
+		template <typename Rep, typename Period>
+		T pop_wait(D*, const T, const std::chrono::duration<Rep, Period>&);
+		void commit();
+		void reset();
+};
+
+/*! Initialize the buffer.
+ *
+ * @sameas CBufferSPSC::CBufferSPSC()
+ */
+template <typename T, typename D, typename W>
+CBufferSPSCS<T, D, W>::CBufferSPSCS(T sz) : CBufferSPSC<T, D, W>{sz}
+{
+}
+
+/*! Clear the buffer and the shadow index.
+ *
+ * \warning not thread-safe, no producer or consumer must be running.
+ */
+template <typename T, typename D, typename W>
+void CBufferSPSCS<T, D, W>::clear()
+{
+	CBufferSPSC<T, D, W>::clear();
+	shadow_start_ = 0;
+}
+
+/** LENght of the buffer from the shadow index.
+ *
+ * @return the objects not read yet.
+ * @sameas CBufferSPSC::len()
+ */
+template <typename T, typename D, typename W>
+T CBufferSPSCS<T, D, W>::len() const
+{
+	return (this->distance(shadow_start_,
+				this->idx_.load(std::memory_order_acquire)));
+}
+
+/*! Read a single object from the shadow index.
+ *
+ * Consumer only, the object stays in the buffer until commit().
+ *
+ * \param data the area where to copy the object.
+ * \return true if ok
+ */
+template <typename T, typename D, typename W>
+bool CBufferSPSCS<T, D, W>::popc(D *data)
+{
+	const T s { shadow_start_ };
+
+	if (!this->available(s, 1))
+		return (false);
+
+	*data = this->buffer_[s];
+	shadow_start_ = this->next(s);
+	return (true);
+}
+
+/*! Read everything present from the shadow index.
+ *
+ * Consumer only, the objects stay in the buffer until commit().
+ *
+ * \param data the area where to copy the objects.
+ * \param sizeofdata.
+ * \return the number of objects fetched.
+ */
+template <typename T, typename D, typename W>
+T CBufferSPSCS<T, D, W>::pop(D* data, const T sizeofdata)
+{
+	T s { shadow_start_ };
+	const T a { this->available(s, sizeofdata) };
+	T j {0};
+
+	while ((j < sizeofdata) && (j < a)) {
+		*(data + j) = this->buffer_[s];
+		s = this->next(s);
+		j++;
+	}
+
+	shadow_start_ = s;
+	return (j);
+}
+
+/*! Read everything from the shadow index to EOM.
+ *
+ * Consumer only, the objects stay in the buffer until commit().
+ *
+ * @sameas CBufferSPSC::popm()
+ */
+template <typename T, typename D, typename W>
+T CBufferSPSCS<T, D, W>::popm(D* data, const T sizeofdata, const D eom)
+{
+	T s { shadow_start_ };
+	const T a { this->available(s, sizeofdata) };
+	T j {0};
+
+	while ((j < sizeofdata) && (j < a)) {
+		*(data + j) = this->buffer_[s];
+		s = this->next(s);
+
+		if (*(data + j) == eom)
+			break;
+
+		j++;
+	}
+
+	shadow_start_ = s;
+	return (j);
+}
+
+/*! Read a single object, wait if nothing is left to read.
+ *
+ * Consumer only, from the shadow index, @sameas popc()
+ *
+ * \param timeout the maximum time to wait.
+ * \return false if still empty after the timeout.
+ */
+template <typename T, typename D, typename W>
+template <typename Rep, typename Period>
+bool CBufferSPSCS<T, D, W>::popc_wait(D* data,
+		const std::chrono::duration<Rep, Period>& timeout)
+{
+	if (popc(data))
+		return (true);
+
+	return (this->not_empty_.wait([this] {
+				return (this->available(shadow_start_, 1) != 0); },
+				CBufferClock::now() + timeout) && popc(data));
+}
+
+/*! Read everything present, wait if nothing is left to read.
+ *
+ * Consumer only, from the shadow index, @sameas pop()
+ *
+ * \param timeout the maximum time to wait for the first object.
+ * \return the number of objects fetched, 0 after the timeout.
+ */
+template <typename T, typename D, typename W>
+template <typename Rep, typename Period>
+T CBufferSPSCS<T, D, W>::pop_wait(D* data, const T sizeofdata,
+		const std::chrono::duration<Rep, Period>& timeout)
+{
+	const T j { pop(data, sizeofdata) };
+
+	if (j || !sizeofdata)
+		return (j);
+
+	if (!this->not_empty_.wait([this] {
+				return (this->available(shadow_start_, 1) != 0); },
+				CBufferClock::now() + timeout))
+		return (0);
+
+	return (pop(data, sizeofdata));
+}
+
+/*! Free the objects read.
+ *
+ * Consumer only, a single release store: the producer can reuse
+ * the slots only after the objects have been copied out.
+ */
+template <typename T, typename D, typename W>
+void CBufferSPSCS<T, D, W>::commit()
+{
+	this->start_.store(shadow_start_, std::memory_order_release);
+	this->not_full_.notify();
+}
+
+/*! Roll back the shadow index to the last commit().
+ *
+ * Consumer only, the objects read since will be read again.
+ */
+template <typename T, typename D, typename W>
+void CBufferSPSCS<T, D, W>::reset()
+{
+	shadow_start_ = this->start_.load(std::memory_order_relaxed);
+}
+
+#endif
@@ -0,0 +1,98 @@
+/* Circular Buffer, an object oriented circular buffer (wait strategies).
+ * Copyright (C) 2015-2021 Enrico Rossi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _CBUFFER_WAIT_H_
+#define _CBUFFER_WAIT_H_
+
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+/** Wait strategies
+
+ How a thread waits for the other side of a lock-free buffer, the
+ W template parameter of CBufferSPSC. A strategy has:
+
+ template <typename F> bool wait(F ready, deadline);
+ Return true as soon as ready() is true, false if the deadline
+ passed first.
+
+ void notify();
+ Called by the other side after every change that can make ready()
+ true, i.e. after the release store of its index.
+
+ CBufferWaitSpin: lowest latency, one core busy while waiting.
+ CBufferWaitYield: spin for a while, then give up the core.
+ CBufferWaitPark, in circular_buffer_wait_park.h: sleep in the
+ kernel (Linux futex), notify() does a system call only if someone
+ is sleeping.
+ */
+
+using CBufferClock = std::chrono::steady_clock;
+
+//! Tell the cpu this is a spin loop.
+inline void cbuffer_pause()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+	__asm__ __volatile__("yield");
+#endif
+}
+
+// Busy wait with a pause instruction.
+struct CBufferWaitSpin {
+	template <typename F>
+	bool wait(F ready, const CBufferClock::time_point deadline) {
+		for (uint32_t i = 1; !ready(); i++) {
+			// the clock is read once every 64 rounds.
+			if (!(i % 64) && (CBufferClock::now() >= deadline))
+				return (ready());
+
+			cbuffer_pause();
+		}
+
+		return (true);
+	}
+
+	void notify() {};
+};
+
+// Spin SPIN rounds, then yield the cpu between checks.
+template <uint32_t SPIN = 100>
+struct CBufferWaitYield {
+	template <typename F>
+	bool wait(F ready, const CBufferClock::time_point deadline) {
+		for (uint32_t i = 0; !ready(); i++) {
+			if (i < SPIN) {
+				cbuffer_pause();
+			} else {
+				if (CBufferClock::now() >= deadline)
+					return (ready());
+
+				std::this_thread::yield();
+			}
+		}
+
+		return (true);
+	}
+
+	void notify() {};
+};
+
+#endif
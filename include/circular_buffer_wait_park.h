@@ -0,0 +1,123 @@
+/* Circular Buffer, an object oriented circular buffer (futex wait).
+ * Copyright (C) 2015-2021 Enrico Rossi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _CBUFFER_WAIT_PARK_H_
+#define _CBUFFER_WAIT_PARK_H_
+
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include "circular_buffer_wait.h"
+
+/* Spin a little, then sleep on a futex, Linux only.
+ *
+ * The waiter registers in waiters_ and checks again, the notifier
+ * publishes and then reads waiters_: with a seq_cst fence on both
+ * sides at least one of them sees the other, so either the waiter
+ * finds the data or the notifier wakes it. The epoch_ read before
+ * registering makes the futex wait fail if a wake came in between.
+ */
+class CBufferWaitPark {
+	private:
+		std::atomic<uint32_t> epoch_ { 0 };
+		std::atomic<uint32_t> waiters_ { 0 };
+		static const uint32_t SPIN { 100 };
+		void sleep(uint32_t, const CBufferClock::duration);
+	public:
+		template <typename F>
+		bool wait(F, const CBufferClock::time_point);
+		void notify();
+};
+
+/*! Sleep until woken, the timeout or epoch_ is not e anymore.
+ *
+ * \param e the epoch read before the last check.
+ * \param timeout the maximum time to sleep.
+ */
+inline void CBufferWaitPark::sleep(uint32_t e, const CBufferClock::duration timeout)
+{
+	const auto ns { std::chrono::duration_cast<std::chrono::nanoseconds>(timeout) };
+	struct timespec ts;
+
+	ts.tv_sec = (time_t)(ns.count() / 1000000000);
+	ts.tv_nsec = (long)(ns.count() % 1000000000);
+	// EAGAIN, EINTR and ETIMEDOUT are all handled by the caller.
+	syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_),
+			FUTEX_WAIT_PRIVATE, e, &ts, nullptr, 0);
+}
+
+/*! Wait for ready() or the deadline.
+ *
+ * \return true if ready() is true.
+ */
+template <typename F>
+bool CBufferWaitPark::wait(F ready, const CBufferClock::time_point deadline)
+{
+	for (uint32_t i = 0; i < SPIN; i++) {
+		if (ready())
+			return (true);
+
+		cbuffer_pause();
+	}
+
+	for (;;) {
+		const uint32_t e { epoch_.load(std::memory_order_acquire) };
+		const auto now { CBufferClock::now() };
+
+		if (now >= deadline)
+			return (ready());
+
+		waiters_.fetch_add(1, std::memory_order_relaxed);
+		// store waiters_, then load the index of the other side.
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		if (ready()) {
+			waiters_.fetch_sub(1, std::memory_order_relaxed);
+			return (true);
+		}
+
+		sleep(e, deadline - now);
+		waiters_.fetch_sub(1, std::memory_order_relaxed);
+
+		if (ready())
+			return (true);
+	}
+}
+
+/*! Wake the waiters, if any.
+ *
+ * To be called after the release store of the index.
+ */
+inline void CBufferWaitPark::notify()
+{
+	// store the index, then load waiters_.
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	if (waiters_.load(std::memory_order_relaxed)) {
+		epoch_.fetch_add(1, std::memory_order_release);
+		syscall(SYS_futex, reinterpret_cast<uint32_t*>(&epoch_),
+				FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+	}
+}
+
+#endif
@@ -33,17 +33,58 @@
   ^---------------------- size -------------------^
  */
 
-// CBuffer of D objects indexed by T type.
-template <typename T, typename D>
+/*! Default object handling.
+ *
+ * The E policy of CBuffer, to customize how the objects are
+ * stored and fetched write a struct with the same static members
+ * and use it as CBuffer<T, D, MyObject>.
+ * The members take the slot by pointer as in circular_buffer.h.
+ * The slots are raw malloc() memory assigned to, D must be
+ * trivially copyable.
+ */
+template <typename D>
+struct CBufferObject {
+	static void pop(D* data, D* slot) { *data = *slot; };
+	static void push(D* slot, const D& c) { *slot = c; };
+};
+
+/*! Default allocator, malloc() and free().
+ *
+ * The A parameter of CBuffer, any type with allocate(n) and
+ * deallocate(p, n) members will do, std::allocator<D> too,
+ * to place the buffer in an arena or a static pool.
+ */
+template <typename D>
+struct CBufferMalloc {
+	typedef D value_type;
+	CBufferMalloc() = default;
+	template <typename U>
+	CBufferMalloc(const CBufferMalloc<U>&) {}
+	D* allocate(size_t n) { return (D*) malloc(sizeof(D) * n); };
+	void deallocate(D* p, size_t) { free(p); };
+};
+
+// Stateless, any CBufferMalloc can free the memory of another.
+template <typename D, typename U>
+bool operator==(const CBufferMalloc<D>&, const CBufferMalloc<U>&) { return (true); }
+
+template <typename D, typename U>
+bool operator!=(const CBufferMalloc<D>&, const CBufferMalloc<U>&) { return (false); }
+
+// CBuffer of D objects indexed by T type, E handles the objects,
+// A allocates the storage.
+template <typename T, typename D, typename E = CBufferObject<D>,
+				 typename A = CBufferMalloc<D>>
 class CBuffer {
 	private:
 		// Fixed array size
+		A alloc_;
 		D* buffer_;
 		T idx_ { 0 };
 		T start_ { 0 };
 		bool overflow_ { false };
-		virtual void pop_object(D*);
-		virtual void push_object(D);
+		void pop_object(D* data) { E::pop(data, buffer_ + start_); };
+		void push_object(D c) { E::push(buffer_ + idx_, c); };
 	protected:
 		const T size_;
 		const T TOP_;
@@ -57,10 +98,10 @@ class CBuffer {
 		T start() const { return start_; };
 		// FIXME i < size_
 		T operator[](T const i) const { return buffer_[i]; };
-		CBuffer(T = CBUF_SIZE); // contructor
-		~CBuffer() { free(buffer_); }; // Destructor
-		virtual void clear();
-		virtual T len() const;
+		CBuffer(T = CBUF_SIZE, const A& = A()); // contructor
+		~CBuffer() { alloc_.deallocate(buffer_, size_); }; // Destructor
+		void clear();
+		T len() const;
 		bool popc(D*);
 		T pop(D*, const T);
 		T popm(D*, const T, const D);
@@ -68,8 +109,8 @@ class CBuffer {
 };
 
 //! Clear the buffer.
-template <typename T, typename D>
-void CBuffer<T, D>::clear()
+template <typename T, typename D, typename E, typename A>
+void CBuffer<T, D, E, A>::clear()
 {
 	idx_ = 0;
 	start_ = 0;
@@ -84,8 +125,8 @@ void CBuffer<T, D>::clear()
  * @return len
  * @note const function does not change any attribute.
  */
-template <typename T, typename D>
-T CBuffer<T, D>::len() const
+template <typename T, typename D, typename E, typename A>
+T CBuffer<T, D, E, A>::len() const
 {
   if (idx_ == start_) {
     if (overflow_)
@@ -101,27 +142,17 @@ T CBuffer<T, D>::len() const
 
 /*! Initialize the buffer.
  *
- * \param plugin enable the check_eom function plugin.
- * \return the allocated struct.
+ * \param sz the number of objects.
+ * \param alloc the allocator of the storage.
  */
-template <typename T, typename D>
-CBuffer<T, D>::CBuffer(T sz) : size_ { sz }, TOP_ { (T)(sz - 1) }
+template <typename T, typename D, typename E, typename A>
+CBuffer<T, D, E, A>::CBuffer(T sz, const A& alloc) :
+	alloc_ { alloc }, size_ { sz }, TOP_ { (T)(sz - 1) }
 {
-	buffer_ = (D*) malloc(sizeof(D) * size_);
+	buffer_ = alloc_.allocate(size_);
 	clear();
 }
 
-/*! Get single object from the buffer.
- *
- * This perform the operation, which can be overridden
- * depending on the type of object.
- */
-template <typename T, typename D>
-void CBuffer<T, D>::pop_object(D *data)
-{
-	*data = buffer_[start_];
-}
-
 /*! Extract a single object from the buffer.
  *
  * data = buffer[start]
@@ -130,11 +161,11 @@ void CBuffer<T, D>::pop_object(D *data)
  * \return true if ok
  * \warning possible race condition!
  */
-template <typename T, typename D>
-bool CBuffer<T, D>::popc(D *data)
+template <typename T, typename D, typename E, typename A>
+bool CBuffer<T, D, E, A>::popc(D *data)
 {
 	if (len()) {
-		pop_object(data); // override me
+		pop_object(data); // E::pop()
 
 		if (start_ == TOP_)
 			start_ = 0;
@@ -162,8 +193,8 @@ bool CBuffer<T, D>::popc(D *data)
  * \warning if the sizeofdata is bigger than the allocated data,
  * it will segfault or worse.
  */
-template <typename T, typename D>
-T CBuffer<T, D>::pop(D* data, const T sizeofdata)
+template <typename T, typename D, typename E, typename A>
+T CBuffer<T, D, E, A>::pop(D* data, const T sizeofdata)
 {
 	T j {0};
 
@@ -190,8 +221,8 @@ T CBuffer<T, D>::pop(D* data, const T sizeofdata)
  * \note EOM is NOT copied.
  * \warning race condition!
  */
-template <typename T, typename D>
-T CBuffer<T, D>::popm(D* data, const T sizeofdata, const D eom)
+template <typename T, typename D, typename E, typename A>
+T CBuffer<T, D, E, A>::popm(D* data, const T sizeofdata, const D eom)
 {
 	T j {0};
 
@@ -204,16 +235,6 @@ T CBuffer<T, D>::popm(D* data, const T sizeofdata, const D eom)
 	return (j);
 }
 
-/*! Push the single object.
- *
- * This function should be overridden.
- */
-template <typename T, typename D>
-void CBuffer<T, D>::push_object(D c)
-{
-	buffer_[idx_] = c;
-}
-
 /*! add data to the buffer.
  *
  * \note if overflow and EOM then the last char must be the EOM.
@@ -221,8 +242,8 @@ void CBuffer<T, D>::push_object(D c)
  * \warning race condition with other functions.
  *  modified members data: overflow_, idx_, buffer_[idx_]
  */
-template <typename T, typename D>
-bool CBuffer<T, D>::push(D c)
+template <typename T, typename D, typename E, typename A>
+bool CBuffer<T, D, E, A>::push(D c)
 {
 	// If the buffer is full do nothing.
 	if (overflow_) {
@@ -239,7 +260,7 @@ bool CBuffer<T, D>::push(D c)
 				overflow_ = true;
 		}
 
-		push_object(c); // override me
+		push_object(c); // E::push()
 
 		if (idx_ == TOP_)
 			idx_ = 0;
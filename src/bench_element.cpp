@@ -0,0 +1,110 @@
+/*
+ * Circular Buffer, an object oriented circular buffer.
+ * Copyright (C) 2015-2021 Enrico Rossi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <cstdint>
+#include <chrono>
+#include "circular_buffer.h"
+
+const uint32_t BUF_SIZE { 1024 }; // buffer size
+const uint32_t LAPS { 50000 }; // fill and empty the buffer LAPS times
+
+using namespace std;
+
+// The old virtual pop_object()/push_object() hooks.
+class Hook {
+	public:
+		virtual ~Hook() = default;
+		virtual void pop(uint32_t* data, const uint32_t& slot) { *data = slot; };
+		virtual void push(uint32_t& slot, uint32_t c) { slot = c; };
+};
+
+// A subclass overriding the hooks, picked at run time.
+class Counting : public Hook {
+	public:
+		uint32_t pushed {0};
+		void push(uint32_t& slot, uint32_t c) override { slot = c; pushed++; };
+};
+
+Hook* hook;
+
+// Object handling through the virtual hooks, as before.
+struct VirtualObject {
+	static void pop(uint32_t* data, uint32_t* slot) { hook->pop(data, *slot); };
+	static void push(uint32_t* slot, uint32_t c) { hook->push(*slot, c); };
+};
+
+// Object handling with the same override, resolved at compile time.
+struct CountingObject {
+	static uint32_t pushed;
+	static void pop(uint32_t* data, uint32_t* slot) { *data = *slot; };
+	static void push(uint32_t* slot, uint32_t c) { *slot = c; pushed++; };
+};
+
+uint32_t CountingObject::pushed {0};
+
+// Fill and empty the buffer one object at a time.
+// \return ns per object (one push and one popc).
+template <typename B>
+double run(B& cbuffer, uint64_t& sum)
+{
+	uint32_t c;
+
+	auto t0 = chrono::steady_clock::now();
+
+	for (uint32_t lap = 0; lap < LAPS; lap++) {
+		for (uint32_t i = 0; i < BUF_SIZE; i++)
+			cbuffer.push(lap + i);
+
+		while (cbuffer.popc(&c))
+			sum += c;
+	}
+
+	chrono::duration<double, nano> ns = chrono::steady_clock::now() - t0;
+	return (ns.count() / ((double)LAPS * BUF_SIZE));
+}
+
+int main(int argc, char**) {
+	CBuffer<uint32_t, uint32_t, VirtualObject> before {BUF_SIZE};
+	CBuffer<uint32_t, uint32_t, CountingObject> after {BUF_SIZE};
+	CBuffer<uint32_t, uint32_t> plain {BUF_SIZE};
+	Counting counting;
+	Hook base;
+	uint64_t sums[3] {0, 0, 0};
+
+	// the compiler cannot know which hook is used.
+	hook = (argc > 1) ? &base : &counting;
+
+	cout << endl << "Benchmark circular buffer, per object cost." << endl;
+	cout << "Copyright (C) 2015-2021 Enrico Rossi - GNU GPL" << endl;
+	cout << endl << LAPS << " laps, push and popc " << BUF_SIZE;
+	cout << " objects." << endl << endl;
+	cout << fixed << setprecision(2);
+	cout << "virtual hook   (before): " << run(before, sums[0]) << " ns" << endl;
+	cout << "E policy       (after) : " << run(after, sums[1]) << " ns" << endl;
+	cout << "CBufferObject  (after) : " << run(plain, sums[2]) << " ns" << endl;
+
+	if ((sums[0] != sums[1]) || (sums[1] != sums[2])) {
+		cout << "Checksum FAIL" << endl;
+		return (1);
+	}
+
+	return (0);
+}
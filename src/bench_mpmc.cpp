@@ -0,0 +1,120 @@
+/*
+ * Circular Buffer, an object oriented circular buffer.
+ * Copyright (C) 2015-2021 Enrico Rossi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <cstdint>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "circular_buffer.h"
+#include "circular_buffer_mpmc.h"
+
+const uint32_t BUF_SIZE { 1024 }; // buffer size
+const uint64_t COUNT { 2000000 }; // objects for every run
+
+using namespace std;
+
+// CBuffer shared behind a mutex, the reference to beat.
+class Locked {
+	private:
+		CBuffer<uint32_t, uint64_t> cbuffer_ {BUF_SIZE};
+		mutex lock_ {};
+	public:
+		bool push(uint64_t c) {
+			lock_guard<mutex> l {lock_};
+			return (cbuffer_.push(c));
+		};
+		bool popc(uint64_t* c) {
+			lock_guard<mutex> l {lock_};
+			return (cbuffer_.popc(c));
+		};
+};
+
+// Run n producers and n consumers, return the checksum error and
+// fill in the elapsed time.
+template <typename B>
+uint64_t run(B& cbuffer, unsigned n, double& secs)
+{
+	vector<thread> threads;
+	vector<uint64_t> sums(n, 0);
+	const uint64_t each { COUNT / n };
+	uint64_t expected {0};
+
+	auto t0 = chrono::steady_clock::now();
+
+	for (unsigned t = 0; t < n; t++)
+		threads.emplace_back([&cbuffer, t, n, each]() {
+				for (uint64_t i = t; i < (each * n); i += n)
+					while (!cbuffer.push(i))
+						this_thread::yield();
+				});
+
+	for (unsigned t = 0; t < n; t++)
+		threads.emplace_back([&cbuffer, &sums, t, each]() {
+				uint64_t c;
+
+				for (uint64_t i = 0; i < each; i++) {
+					while (!cbuffer.popc(&c))
+						this_thread::yield();
+
+					sums[t] += c;
+				}
+				});
+
+	for (auto& t : threads)
+		t.join();
+
+	secs = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+
+	for (uint64_t i = 0; i < (each * n); i++)
+		expected += i;
+
+	for (auto s : sums)
+		expected -= s;
+
+	return (expected);
+}
+
+int main() {
+	uint64_t errors {0};
+	double secs;
+
+	cout << endl << "Benchmark circular buffer (bounded MPMC)." << endl;
+	cout << "Copyright (C) 2015-2021 Enrico Rossi - GNU GPL" << endl;
+	cout << endl << COUNT << " objects, n producers and n consumers, ";
+	cout << "Mops/s." << endl << endl;
+	cout << setw(4) << "n" << setw(12) << "mutex" << setw(12) << "mpmc" << endl;
+
+	for (unsigned n : {1, 2, 4, 8}) {
+		Locked locked;
+		CBufferMPMC<uint32_t, uint64_t> mpmc {BUF_SIZE};
+
+		cout << setw(4) << n << fixed << setprecision(2);
+		errors += run(locked, n, secs);
+		cout << setw(12) << (COUNT / secs / 1e6);
+		errors += run(mpmc, n, secs);
+		cout << setw(12) << (COUNT / secs / 1e6) << endl;
+	}
+
+	cout << endl << "Errors: " << errors << (errors ? " FAIL" : " OK") << endl;
+
+	return (errors ? 1 : 0);
+}
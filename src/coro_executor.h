@@ -0,0 +1,59 @@
+/*
+ * Circular Buffer, an object oriented circular buffer.
+ * Copyright (C) 2015-2021 Enrico Rossi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#ifndef _CORO_EXECUTOR_H_
+#define _CORO_EXECUTOR_H_
+
+#include <coroutine>
+#include <deque>
+#include <exception>
+
+// Single threaded executor, resume the posted coroutines in order.
+class Executor {
+	private:
+		std::deque<std::coroutine_handle<>> ready_ {};
+	public:
+		void post(std::coroutine_handle<> h) { ready_.push_back(h); };
+		void run();
+};
+
+//! Run until no coroutine is ready.
+inline void Executor::run()
+{
+	while (!ready_.empty()) {
+		std::coroutine_handle<> h { ready_.front() };
+
+		ready_.pop_front();
+		h.resume();
+	}
+}
+
+// Fire and forget coroutine, it runs until the first co_await and
+// its frame is freed at the end.
+struct Task {
+	struct promise_type {
+		Task get_return_object() { return {}; };
+		std::suspend_never initial_suspend() noexcept { return {}; };
+		std::suspend_never final_suspend() noexcept { return {}; };
+		void return_void() {};
+		void unhandled_exception() { std::terminate(); };
+	};
+};
+
+#endif
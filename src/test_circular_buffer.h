@@ -22,7 +22,17 @@
 // ./runner
 
 #include <cxxtest/TestSuite.h>
+#include <string>
 #include "circular_buffer.h"
+#include "circular_buffer_shadow.h"
+#include "circular_buffer_pow2.h"
+#include "circular_buffer_fixed.h"
+#include "circular_buffer_mirror.h"
+#include "circular_buffer_eventfd.h"
+#include "circular_buffer_record.h"
+#include "circular_buffer_message.h"
+#include "circular_buffer_delim.h"
+#include <poll.h>
 
 class TestSuite1 : public CxxTest::TestSuite
 {
@@ -202,4 +212,895 @@ class TestSuite1 : public CxxTest::TestSuite
 			TS_ASSERT_EQUALS(cbuffer.index(), 2);
 			TS_ASSERT(!cbuffer.overflow());
 		}
+
+		void testBulk(void)
+		{
+			const uint8_t abc[] {'a', 'b', 'c', 'd', 'e', 'f'};
+
+			// [abc]
+			TS_ASSERT_EQUALS(cbuffer.push(abc, 3), 3);
+			TS_ASSERT_EQUALS(cbuffer.len(), 3);
+			TS_ASSERT_EQUALS(cbuffer.index(), 3);
+			TS_ASSERT_EQUALS(cbuffer.pop(data, 2), 2);
+			TS_ASSERT_EQUALS(data[0], 'a');
+			TS_ASSERT_EQUALS(data[1], 'b');
+
+			// wrap around, only 4 fit: [ef?cd]
+			TS_ASSERT_EQUALS(cbuffer.push(abc + 2, 6), 4);
+			TS_ASSERT_EQUALS(cbuffer.len(), 5);
+			TS_ASSERT_EQUALS(cbuffer.index(), 2);
+			TS_ASSERT(cbuffer.overflow());
+			TS_ASSERT_EQUALS(cbuffer.push(abc, 1), 0);
+
+			// two segments
+			TS_ASSERT_EQUALS(cbuffer.pop(data, datasize), 5);
+			TS_ASSERT_EQUALS(data[0], 'c');
+			TS_ASSERT_EQUALS(data[1], 'c');
+			TS_ASSERT_EQUALS(data[2], 'd');
+			TS_ASSERT_EQUALS(data[3], 'e');
+			TS_ASSERT_EQUALS(data[4], 'f');
+
+			TS_ASSERT_EQUALS(cbuffer.start(), 2);
+			TS_ASSERT_EQUALS(cbuffer.len(), 0);
+			TS_ASSERT(!cbuffer.overflow());
+		}
+
+		void testMessage(void)
+		{
+			const uint8_t msg[] {'a', 'b', 'X', 'c', 'X'};
+
+			// [??abX] [cX???] wrap around
+			TS_ASSERT_EQUALS(cbuffer.push(msg, 3), 3);
+			TS_ASSERT_EQUALS(cbuffer.pop(data, 3), 3);
+			TS_ASSERT_EQUALS(cbuffer.push(msg, 5), 5);
+			TS_ASSERT_EQUALS(cbuffer.start(), 3);
+
+			// EOM in the first segment
+			TS_ASSERT_EQUALS(cbuffer.popm(data, datasize, 'X'), 2);
+			TS_ASSERT_EQUALS(data[0], 'a');
+			TS_ASSERT_EQUALS(data[1], 'b');
+			TS_ASSERT_EQUALS(cbuffer.len(), 2);
+
+			// EOM in the second segment
+			TS_ASSERT_EQUALS(cbuffer.push(msg, 3), 3);
+			TS_ASSERT_EQUALS(cbuffer.popm(data, datasize, 'X'), 1);
+			TS_ASSERT_EQUALS(data[0], 'c');
+
+			// data too small, the rest stays in the buffer
+			TS_ASSERT_EQUALS(cbuffer.popm(data, 1, 'X'), 1);
+			TS_ASSERT_EQUALS(data[0], 'a');
+			TS_ASSERT_EQUALS(cbuffer.len(), 2);
+
+			// no EOM, like pop()
+			TS_ASSERT_EQUALS(cbuffer.popm(data, datasize, 'Z'), 2);
+			TS_ASSERT_EQUALS(data[0], 'b');
+			TS_ASSERT_EQUALS(data[1], 'X');
+			TS_ASSERT_EQUALS(cbuffer.len(), 0);
+			TS_ASSERT_EQUALS(cbuffer.popm(data, datasize, 'X'), 0);
+		}
+
+		void testPeek(void)
+		{
+			const uint8_t abc[] {'a', 'b', 'c', 'd', 'e'};
+			CBufferSegment<uint8_t, const uint8_t> first, second;
+
+			TS_ASSERT_EQUALS(cbuffer.peek(first, second), 0);
+			TS_ASSERT_EQUALS(first.len, 0);
+			TS_ASSERT_EQUALS(second.len, 0);
+
+			// [bc?da]
+			TS_ASSERT_EQUALS(cbuffer.push(abc, 4), 4);
+			TS_ASSERT_EQUALS(cbuffer.consume(3), 3);
+			TS_ASSERT_EQUALS(cbuffer.push(abc, 3), 3);
+			TS_ASSERT_EQUALS(cbuffer.peek(first, second), 4);
+			TS_ASSERT_EQUALS(first.len, 2);
+			TS_ASSERT_EQUALS(first.data[0], 'd');
+			TS_ASSERT_EQUALS(first.data[1], 'a');
+			TS_ASSERT_EQUALS(second.len, 2);
+			TS_ASSERT_EQUALS(second.data[0], 'b');
+			TS_ASSERT_EQUALS(second.data[1], 'c');
+			TS_ASSERT_EQUALS(cbuffer.len(), 4);
+
+			TS_ASSERT_EQUALS(cbuffer.consume(3), 3);
+			TS_ASSERT_EQUALS(cbuffer.peek(first, second), 1);
+			TS_ASSERT_EQUALS(first.data[0], 'c');
+			TS_ASSERT_EQUALS(second.len, 0);
+			TS_ASSERT_EQUALS(cbuffer.consume(9), 1);
+			TS_ASSERT_EQUALS(cbuffer.len(), 0);
+		}
+
+		void testReserve(void)
+		{
+			CBufferSegment<uint8_t, uint8_t> first, second;
+
+			// [??cde] -> [ab?de]
+			TS_ASSERT_EQUALS(cbuffer.reserve(first, second, 3), 3);
+			TS_ASSERT_EQUALS(first.len, 3);
+			TS_ASSERT_EQUALS(second.len, 0);
+			TS_ASSERT_EQUALS(cbuffer.publish(3), 3);
+			TS_ASSERT_EQUALS(cbuffer.consume(2), 2);
+
+			TS_ASSERT_EQUALS(cbuffer.reserve(first, second, 9), 4);
+			TS_ASSERT_EQUALS(first.len, 2);
+			TS_ASSERT_EQUALS(second.len, 2);
+			first.data[0] = 'd';
+			first.data[1] = 'e';
+			second.data[0] = 'a';
+			second.data[1] = 'b';
+			TS_ASSERT_EQUALS(cbuffer.len(), 1);
+			TS_ASSERT_EQUALS(cbuffer.publish(4), 4);
+			TS_ASSERT_EQUALS(cbuffer.len(), 5);
+			TS_ASSERT(cbuffer.overflow());
+			TS_ASSERT_EQUALS(cbuffer.reserve(first, second, 1), 0);
+			TS_ASSERT_EQUALS(cbuffer.publish(1), 0);
+
+			TS_ASSERT(cbuffer.popc(data));
+			TS_ASSERT_EQUALS(cbuffer.pop(data, datasize), 4);
+			TS_ASSERT_EQUALS(data[0], 'd');
+			TS_ASSERT_EQUALS(data[3], 'b');
+		}
+
+};
+
+// count the live objects.
+struct Alive {
+	static int count;
+	int v;
+	Alive(int i = 0) : v {i} { count++; };
+	Alive(const Alive& a) : v {a.v} { count++; };
+	Alive& operator=(const Alive&) = default;
+	~Alive() { count--; };
+};
+
+int Alive::count {0};
+
+class TestSuiteObject : public CxxTest::TestSuite
+{
+	private:
+		CBuffer<uint8_t, std::string> cbuffer {3};
+
+	public:
+		void testMove(void)
+		{
+			std::string s (100, 'a');
+			const char* payload { s.data() };
+			std::string data[3];
+
+			TS_ASSERT(cbuffer.push(std::move(s)));
+			TS_ASSERT(cbuffer.emplace(50, 'b'));
+			TS_ASSERT(cbuffer.push(std::string ("c")));
+			TS_ASSERT(!cbuffer.emplace(1, 'x'));
+
+			// the payload moved in and out, no copy.
+			TS_ASSERT(cbuffer.popc(data));
+			TS_ASSERT_EQUALS(data[0].data(), payload);
+			TS_ASSERT_EQUALS(data[0].size(), 100);
+
+			TS_ASSERT_EQUALS(cbuffer.pop(data, 3), 2);
+			TS_ASSERT_EQUALS(data[0], std::string (50, 'b'));
+			TS_ASSERT_EQUALS(data[1], "c");
+			TS_ASSERT_EQUALS(cbuffer.len(), 0);
+		}
+};
+
+class TestSuiteLifetime : public CxxTest::TestSuite
+{
+	public:
+		void testLifetime(void)
+		{
+			Alive data[4];
+
+			TS_ASSERT_EQUALS(Alive::count, 4);
+
+			{
+				CBuffer<uint8_t, Alive> cbuffer {200};
+
+				// no object constructed upfront.
+				TS_ASSERT_EQUALS(Alive::count, 4);
+				TS_ASSERT(cbuffer.emplace(1));
+				TS_ASSERT(cbuffer.push(Alive {2}));
+				TS_ASSERT(cbuffer.push(data, 3) == 3);
+				TS_ASSERT_EQUALS(Alive::count, 4 + 5);
+
+				TS_ASSERT(cbuffer.popc(data));
+				TS_ASSERT_EQUALS(data[0].v, 1);
+				TS_ASSERT_EQUALS(Alive::count, 4 + 4);
+				TS_ASSERT_EQUALS(cbuffer.consume(1), 1);
+				TS_ASSERT_EQUALS(Alive::count, 4 + 3);
+				TS_ASSERT_EQUALS(cbuffer.pop(data, 1), 1);
+				TS_ASSERT_EQUALS(Alive::count, 4 + 2);
+				cbuffer.clear();
+				TS_ASSERT_EQUALS(Alive::count, 4);
+				TS_ASSERT(cbuffer.emplace(3));
+			}
+
+			// the destructor destroyed the object left.
+			TS_ASSERT_EQUALS(Alive::count, 4);
+
+			{
+				CBufferS<uint8_t, Alive> cbuffer {5};
+
+				for (auto i = 0; i < 5; i++)
+					TS_ASSERT(cbuffer.emplace(i));
+
+				TS_ASSERT_EQUALS(cbuffer.pop(data, 2), 2);
+				TS_ASSERT_EQUALS(Alive::count, 4 + 5);
+				cbuffer.reset();
+				TS_ASSERT_EQUALS(cbuffer.pop(data, 3), 3);
+				cbuffer.commit();
+				TS_ASSERT_EQUALS(Alive::count, 4 + 2);
+			}
+
+			TS_ASSERT_EQUALS(Alive::count, 4);
+		}
+};
+
+class TestSuitePow2 : public CxxTest::TestSuite
+{
+	private:
+		CBufferPow2<uint8_t, uint8_t> cbuffer {128};
+		uint8_t data[128];
+
+	public:
+		void setUp()
+		{
+			cbuffer.clear();
+		}
+
+		void testSize(void)
+		{
+			TS_ASSERT_THROWS((CBufferPow2<uint8_t, uint8_t> {15}),
+					std::invalid_argument);
+			TS_ASSERT_THROWS((CBufferPow2<uint8_t, uint8_t> {0}),
+					std::invalid_argument);
+			TS_ASSERT_THROWS((CBufferPow2<uint8_t, uint8_t> {255}),
+					std::invalid_argument);
+		}
+
+		void testCounterWrap(void)
+		{
+			// run the free counters over the end of uint8_t
+			for (auto lap = 0; lap < 5; lap++) {
+				for (auto i = 0; i < 100; i++)
+					TS_ASSERT(cbuffer.push(i));
+
+				TS_ASSERT_EQUALS(cbuffer.len(), 100);
+				TS_ASSERT_EQUALS(cbuffer.pop(data, 100), 100);
+
+				for (auto i = 0; i < 100; i++)
+					TS_ASSERT_EQUALS(data[i], i);
+			}
+
+			TS_ASSERT_EQUALS(cbuffer.len(), 0);
+			TS_ASSERT_EQUALS(cbuffer.index(), (500 % 256) & 127);
+
+			// fill up
+			for (auto i = 0; i < 128; i++)
+				TS_ASSERT(cbuffer.push(i));
+
+			TS_ASSERT(cbuffer.overflow());
+			TS_ASSERT(!cbuffer.push('x'));
+			TS_ASSERT(cbuffer.popc(data));
+			TS_ASSERT_EQUALS(data[0], 0);
+			TS_ASSERT_EQUALS(cbuffer.len(), 127);
+		}
+
+		void testPopm(void)
+		{
+			const uint8_t msg[] {'a', 'b', 'X', 'c', 'X', 'd'};
+
+			// the messages across the end of the buffer
+			for (auto i = 0; i < 125; i++)
+				TS_ASSERT(cbuffer.push(i));
+
+			TS_ASSERT_EQUALS(cbuffer.pop(data, 125), 125);
+			TS_ASSERT_EQUALS(cbuffer.push(msg, 6), 6);
+			TS_ASSERT_EQUALS(cbuffer.popm(data, 10, 'X'), 2);
+			TS_ASSERT_EQUALS(data[1], 'b');
+			TS_ASSERT_EQUALS(data[2], 'X');
+			TS_ASSERT_EQUALS(cbuffer.popm(data, 10, 'X'), 1);
+			TS_ASSERT_EQUALS(data[0], 'c');
+			// no EOM, everything is popped.
+			TS_ASSERT_EQUALS(cbuffer.popm(data, 10, 'X'), 1);
+			TS_ASSERT_EQUALS(data[0], 'd');
+			TS_ASSERT_EQUALS(cbuffer.len(), 0);
+			// data full before the EOM, the rest stays.
+			TS_ASSERT_EQUALS(cbuffer.push(msg, 6), 6);
+			TS_ASSERT_EQUALS(cbuffer.popm(data, 1, 'X'), 1);
+			TS_ASSERT_EQUALS(cbuffer.len(), 5);
+		}
+};
+
+class TestSuiteFixed : public CxxTest::TestSuite
+{
+	public:
+		void testInline(void)
+		{
+			CBufferFixed<uint8_t, uint8_t, 5> cbuffer;
+			const uint8_t abc[] {'a', 'b', 'c', 'd', 'e'};
+			uint8_t data[5];
+
+			// no pointer, the objects are in the class.
+			TS_ASSERT(sizeof(cbuffer) < 16);
+			TS_ASSERT_EQUALS(cbuffer.size(), 5);
+			TS_ASSERT_EQUALS(cbuffer.len(), 0);
+
+			TS_ASSERT_EQUALS(cbuffer.push(abc, 3), 3);
+			TS_ASSERT_EQUALS(cbuffer.pop(data, 2), 2);
+			TS_ASSERT_EQUALS(cbuffer.push(abc, 5), 4);
+			TS_ASSERT(cbuffer.overflow());
+			TS_ASSERT(!cbuffer.push('x'));
+			TS_ASSERT_EQUALS(cbuffer.index(), 2);
+
+			// [cabcd]
+			TS_ASSERT_EQUALS(cbuffer.pop(data, 5), 5);
+			TS_ASSERT_EQUALS(data[0], 'c');
+			TS_ASSERT_EQUALS(data[1], 'a');
+			TS_ASSERT_EQUALS(data[4], 'd');
+			TS_ASSERT_EQUALS(cbuffer.len(), 0);
+			TS_ASSERT(!cbuffer.overflow());
+		}
+
+		void testPopm(void)
+		{
+			CBufferFixed<uint8_t, uint8_t, 5> cbuffer;
+			const uint8_t msg[] {'a', 'X', 'b', 'c', 'X'};
+			uint8_t data[5];
+
+			// [bcX..a] then [X....]
+			TS_ASSERT_EQUALS(cbuffer.push(msg, 3), 3);
+			TS_ASSERT_EQUALS(cbuffer.pop(data, 3), 3);
+			TS_ASSERT_EQUALS(cbuffer.push(msg, 5), 5);
+			TS_ASSERT_EQUALS(cbuffer.popm(data, 5, 'X'), 1);
+			TS_ASSERT_EQUALS(data[1], 'X');
+			TS_ASSERT_EQUALS(cbuffer.popm(data, 5, 'X'), 2);
+			TS_ASSERT_EQUALS(data[0], 'b');
+			TS_ASSERT_EQUALS(data[2], 'X');
+			TS_ASSERT_EQUALS(cbuffer.len(), 0);
+			TS_ASSERT(!cbuffer.overflow());
+		}
+};
+
+class TestSuiteMirror : public CxxTest::TestSuite
+{
+	public:
+		void testSeam(void)
+		{
+			CBufferMirror<uint32_t, uint8_t> cbuffer {4096};
+			uint8_t data[4096];
+			const uint8_t* p;
+
+			TS_ASSERT_THROWS((CBufferMirror<uint32_t, uint8_t> {100}),
+					std::invalid_argument);
+
+			// move start near the end
+			for (auto i = 0; i < 4000; i++)
+				data[i] = 'x';
+
+			TS_ASSERT_EQUALS(cbuffer.push(data, 4000), 4000);
+			TS_ASSERT_EQUALS(cbuffer.consume(4000), 4000);
+
+			// a message across the end of the buffer
+			memcpy(data, "0123456789abcdef0123456789abcdef"
+					"0123456789abcdef0123456789abcdef"
+					"0123456789abcdef0123456789abcdef\n", 97);
+			TS_ASSERT_EQUALS(cbuffer.push(data, 97), 97);
+			TS_ASSERT_EQUALS(cbuffer.index(), 1);
+			TS_ASSERT_EQUALS(cbuffer.peek(&p), 97);
+			TS_ASSERT_EQUALS(p[96], '\n');
+			TS_ASSERT_EQUALS(memchr(p, '\n', 97), p + 96);
+
+			// the second copy is the first one
+			TS_ASSERT_EQUALS(cbuffer[0], '\n');
+
+			memset(data, 0, 97);
+			TS_ASSERT_EQUALS(cbuffer.popm(data, 4096, '\n'), 96);
+			TS_ASSERT_EQUALS(data[95], 'f');
+			TS_ASSERT_EQUALS(cbuffer.len(), 0);
+			TS_ASSERT_EQUALS(cbuffer.start(), 1);
+		}
+};
+
+// Allocator counting the live allocations.
+template <typename D>
+struct Counted {
+	using value_type = D;
+	int* live;
+	explicit Counted(int* l) : live { l } {};
+	template <typename U> Counted(const Counted<U>& o) : live { o.live } {}
+	D* allocate(size_t n) { (*live)++; return std::allocator<D>().allocate(n); };
+	void deallocate(D* p, size_t n) { (*live)--; std::allocator<D>().deallocate(p, n); };
+};
+
+class TestSuiteAllocator : public CxxTest::TestSuite
+{
+	public:
+		void testAllocator(void)
+		{
+			int live {0};
+			std::string data[4];
+
+			{
+				CBuffer<uint8_t, std::string, CBufferObject<std::string>,
+					Counted<std::string>> cbuffer {4, Counted<std::string> {&live}};
+
+				TS_ASSERT_EQUALS(live, 1);
+				TS_ASSERT(cbuffer.push(std::string("abc")));
+				TS_ASSERT(cbuffer.push(std::string("def")));
+				TS_ASSERT_EQUALS(cbuffer.pop(data, 4), 2);
+				TS_ASSERT_EQUALS(data[1], "def");
+			}
+
+			TS_ASSERT_EQUALS(live, 0);
+		}
+};
+
+class TestSuiteOverwrite : public CxxTest::TestSuite
+{
+	public:
+		void testOverwrite(void)
+		{
+			CBuffer<uint8_t, uint8_t> cbuffer {4};
+			const uint8_t data[] {'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i'};
+			uint8_t out[10];
+
+			cbuffer.overwrite(true);
+
+			for (auto i = 0; i < 6; i++)
+				TS_ASSERT(cbuffer.push(data[i]));
+
+			TS_ASSERT_EQUALS(cbuffer.len(), 4);
+			TS_ASSERT_EQUALS(cbuffer.dropped(), 2);
+			TS_ASSERT_EQUALS(cbuffer.pop(out, 10), 4);
+			TS_ASSERT_EQUALS(out[0], 'c');
+			TS_ASSERT_EQUALS(out[3], 'f');
+
+			// bulk, only the newest ones are kept
+			TS_ASSERT_EQUALS(cbuffer.push(data, 3), 3);
+			TS_ASSERT_EQUALS(cbuffer.push(data + 3, 3), 3);
+			TS_ASSERT_EQUALS(cbuffer.dropped(), 4);
+			TS_ASSERT_EQUALS(cbuffer.push(data, 9), 9);
+			TS_ASSERT_EQUALS(cbuffer.dropped(), 13);
+			TS_ASSERT_EQUALS(cbuffer.pop(out, 10), 4);
+			TS_ASSERT_EQUALS(out[0], 'f');
+			TS_ASSERT_EQUALS(out[3], 'i');
+
+			// default, full buffer rejects
+			cbuffer.overwrite(false);
+			TS_ASSERT_EQUALS(cbuffer.push(data, 9), 4);
+			TS_ASSERT(!cbuffer.push('z'));
+			TS_ASSERT_EQUALS(cbuffer.dropped(), 13);
+		}
+
+		void testShadow(void)
+		{
+			CBufferS<uint8_t, uint8_t> cbuffer {4};
+			uint8_t c;
+
+			cbuffer.overwrite(true);
+
+			for (uint8_t i = 1; i < 5; i++)
+				cbuffer.push(i);
+
+			// read everything of a full buffer
+			TS_ASSERT(cbuffer.popc(&c));
+			TS_ASSERT(cbuffer.popc(&c));
+			TS_ASSERT(cbuffer.popc(&c));
+			TS_ASSERT(cbuffer.popc(&c));
+			TS_ASSERT_EQUALS(cbuffer.len(), 0);
+			TS_ASSERT(!cbuffer.popc(&c));
+			cbuffer.reset();
+
+			// 1 and 2 read, 1 dropped, read from 3 on.
+			TS_ASSERT(cbuffer.popc(&c));
+			TS_ASSERT(cbuffer.popc(&c));
+			TS_ASSERT(cbuffer.push(5));
+			TS_ASSERT_EQUALS(cbuffer.len(), 3);
+			TS_ASSERT(cbuffer.popc(&c));
+			TS_ASSERT_EQUALS(c, 3);
+
+			// 2 and 3 read, 2, 3 and 4 dropped, the shadow is moved.
+			TS_ASSERT(cbuffer.push(6));
+			TS_ASSERT(cbuffer.push(7));
+			TS_ASSERT(cbuffer.push(8));
+			TS_ASSERT_EQUALS(cbuffer.len(), 4);
+			TS_ASSERT(cbuffer.popc(&c));
+			TS_ASSERT_EQUALS(c, 5);
+			cbuffer.commit();
+			TS_ASSERT_EQUALS(cbuffer.CBuffer::len(), 3);
+			TS_ASSERT_EQUALS(cbuffer.dropped(), 4);
+
+			// emplace() drops like push(): 0 and 1 read, 0 dropped.
+			cbuffer.clear();
+
+			for (uint8_t i = 0; i < 4; i++)
+				cbuffer.push(i);
+
+			TS_ASSERT(cbuffer.popc(&c));
+			TS_ASSERT(cbuffer.popc(&c));
+			TS_ASSERT(cbuffer.emplace(9));
+			TS_ASSERT_EQUALS(cbuffer.len(), 3);
+			TS_ASSERT(cbuffer.popc(&c));
+			TS_ASSERT_EQUALS(c, 2);
+			cbuffer.reset();
+			TS_ASSERT(cbuffer.popc(&c));
+			TS_ASSERT_EQUALS(c, 1);
+		}
+};
+
+class TestSuiteEventfd : public CxxTest::TestSuite
+{
+	public:
+		void testThreshold(void)
+		{
+			CBufferEventfd<uint8_t, uint8_t> cbuffer {8, 3};
+			struct pollfd pfd { cbuffer.fd(), POLLIN, 0 };
+			uint8_t data[8];
+			uint64_t n;
+
+			TS_ASSERT(cbuffer.push('a'));
+			TS_ASSERT(cbuffer.push('b'));
+			TS_ASSERT_EQUALS(poll(&pfd, 1, 0), 0);
+			TS_ASSERT(cbuffer.push('c'));
+			TS_ASSERT(cbuffer.push('d'));
+			TS_ASSERT_EQUALS(poll(&pfd, 1, 0), 1);
+
+			// one write only for the burst.
+			TS_ASSERT_EQUALS(read(cbuffer.fd(), &n, sizeof(n)), 8);
+			TS_ASSERT_EQUALS(n, 1);
+
+			// still 3 objects after the pop, do not wait.
+			TS_ASSERT_EQUALS(cbuffer.pop(data, 1), 1);
+			TS_ASSERT(cbuffer.rearm());
+			TS_ASSERT_EQUALS(cbuffer.pop(data, 8), 3);
+			TS_ASSERT(!cbuffer.rearm());
+			TS_ASSERT_EQUALS(poll(&pfd, 1, 0), 0);
+		}
+
+		void testPushWait(void)
+		{
+			CBufferEventfd<uint8_t, uint8_t> cbuffer {2};
+			struct pollfd pfd { cbuffer.fd(), POLLIN, 0 };
+			uint8_t data[2];
+
+			// push_wait() signals like push().
+			TS_ASSERT(cbuffer.push_wait('a', std::chrono::milliseconds(1)));
+			TS_ASSERT_EQUALS(poll(&pfd, 1, 0), 1);
+			TS_ASSERT_EQUALS(cbuffer.pop(data, 2), 1);
+			TS_ASSERT(!cbuffer.rearm());
+			TS_ASSERT_EQUALS(poll(&pfd, 1, 0), 0);
+			TS_ASSERT(cbuffer.push_wait('b', std::chrono::milliseconds(1)));
+			TS_ASSERT_EQUALS(poll(&pfd, 1, 0), 1);
+
+			// full, the timeout expires.
+			TS_ASSERT(cbuffer.push('c'));
+			TS_ASSERT(!cbuffer.push_wait('d', std::chrono::milliseconds(1)));
+
+			cbuffer.threshold(0);
+			TS_ASSERT_EQUALS(cbuffer.threshold(), 1);
+		}
+};
+
+class TestSuiteRecord : public CxxTest::TestSuite
+{
+	public:
+		void testRecord(void)
+		{
+			CBufferR<uint16_t> cbuffer {300};
+			uint8_t data[300];
+			uint8_t out[300];
+			uint16_t n;
+
+			for (auto i = 0; i < 300; i++)
+				data[i] = (uint8_t)i;
+
+			TS_ASSERT(!cbuffer.peekr(&n));
+			TS_ASSERT(!cbuffer.popr(out, 300, &n));
+			TS_ASSERT_EQUALS(CBufferR<uint16_t>::header_len(127), 1);
+			TS_ASSERT_EQUALS(CBufferR<uint16_t>::header_len(128), 2);
+
+			// 1 + 0, 1 + 5, 2 + 200 bytes
+			TS_ASSERT(cbuffer.pushr(data, 0));
+			TS_ASSERT(cbuffer.pushr(data, 5));
+			TS_ASSERT(cbuffer.pushr(data, 200));
+			TS_ASSERT_EQUALS(cbuffer.len(), 209);
+
+			// no room for 1 + 91, nothing pushed
+			TS_ASSERT(!cbuffer.pushr(data, 91));
+			TS_ASSERT_EQUALS(cbuffer.len(), 209);
+			TS_ASSERT(cbuffer.pushr(data, 90));
+			TS_ASSERT(cbuffer.overflow());
+
+			TS_ASSERT(cbuffer.popr(out, 300, &n));
+			TS_ASSERT_EQUALS(n, 0);
+			TS_ASSERT(cbuffer.popr(out, 300, &n));
+			TS_ASSERT_EQUALS(n, 5);
+			TS_ASSERT_EQUALS(out[4], 4);
+
+			// too small, the record stays
+			TS_ASSERT(!cbuffer.popr(out, 199, &n));
+			TS_ASSERT_EQUALS(n, 200);
+			TS_ASSERT(cbuffer.peekr(&n));
+			TS_ASSERT_EQUALS(n, 200);
+			TS_ASSERT(cbuffer.popr(out, 200, &n));
+			TS_ASSERT_EQUALS(out[0], 0);
+			TS_ASSERT_EQUALS(out[199], 199);
+
+			TS_ASSERT(cbuffer.popr(out, 300, &n));
+			TS_ASSERT_EQUALS(n, 90);
+			TS_ASSERT_EQUALS(cbuffer.len(), 0);
+		}
+
+		void testRecordWrap(void)
+		{
+			CBufferR<uint16_t> cbuffer {300};
+			uint8_t data[300];
+			uint8_t out[300];
+			uint16_t n;
+
+			for (auto i = 0; i < 300; i++)
+				data[i] = (uint8_t)i;
+
+			// 2 + 297 bytes, start at 299
+			TS_ASSERT(cbuffer.pushr(data, 297));
+			TS_ASSERT(cbuffer.popr(out, 300, &n));
+			TS_ASSERT_EQUALS(cbuffer.start(), 299);
+
+			// the header across the end of the buffer
+			TS_ASSERT(cbuffer.pushr(data + 10, 150));
+			TS_ASSERT(cbuffer.peekr(&n));
+			TS_ASSERT_EQUALS(n, 150);
+			TS_ASSERT(cbuffer.popr(out, 300, &n));
+			TS_ASSERT_EQUALS(out[0], 10);
+			TS_ASSERT_EQUALS(out[149], 159);
+			TS_ASSERT_EQUALS(cbuffer.len(), 0);
+		}
+};
+
+class TestSuiteMessages : public CxxTest::TestSuite
+{
+	public:
+		void testMessages(void)
+		{
+			CBufferM<uint8_t, uint8_t> cbuffer {'\n', 16};
+			uint8_t data[16];
+			uint8_t n;
+
+			TS_ASSERT_EQUALS(cbuffer.push((const uint8_t*)"ab\ncd", 5), 5);
+			TS_ASSERT_EQUALS(cbuffer.messages(), 1);
+
+			// a message, then only a partial one
+			TS_ASSERT(cbuffer.popmsg(data, 16, &n));
+			TS_ASSERT_EQUALS(n, 2);
+			TS_ASSERT_EQUALS(data[2], '\n');
+			TS_ASSERT(!cbuffer.popmsg(data, 16, &n));
+			TS_ASSERT_EQUALS(cbuffer.len(), 2);
+
+			// "cdef\n" does not fit in 4
+			TS_ASSERT(cbuffer.push('e'));
+			TS_ASSERT(cbuffer.push('f'));
+			TS_ASSERT(cbuffer.push('\n'));
+			TS_ASSERT_EQUALS(cbuffer.messages(), 1);
+			TS_ASSERT(!cbuffer.popmsg(data, 4, &n));
+			TS_ASSERT_EQUALS(n, 4);
+			TS_ASSERT_EQUALS(cbuffer.len(), 5);
+			TS_ASSERT(cbuffer.popmsg(data, 5, &n));
+			TS_ASSERT_EQUALS(cbuffer.messages(), 0);
+
+			// pop() and consume() remove the EOMs too
+			cbuffer.push((const uint8_t*)"1\n2\n3\n4\n", 8);
+			TS_ASSERT_EQUALS(cbuffer.messages(), 4);
+			TS_ASSERT_EQUALS(cbuffer.pop(data, 3), 3);
+			TS_ASSERT_EQUALS(cbuffer.messages(), 3);
+			TS_ASSERT_EQUALS(cbuffer.consume(2), 2);
+			TS_ASSERT_EQUALS(cbuffer.messages(), 2);
+			TS_ASSERT_EQUALS(cbuffer.popm(data, 16, '\n'), 0);
+			TS_ASSERT_EQUALS(cbuffer.messages(), 1);
+			TS_ASSERT(cbuffer.popc(data));
+			TS_ASSERT(cbuffer.popc(data));
+			TS_ASSERT_EQUALS(cbuffer.messages(), 0);
+
+			// a NUL EOM is not taken for a null count.
+			TS_ASSERT_EQUALS(cbuffer.popm(data, 16, 0), 0);
+		}
+
+		void testOverwrite(void)
+		{
+			CBufferM<uint8_t, uint8_t> cbuffer {'\n', 4};
+			uint8_t data[4];
+			uint8_t n;
+
+			cbuffer.overwrite(true);
+			cbuffer.push((const uint8_t*)"a\nb\n", 4);
+			TS_ASSERT_EQUALS(cbuffer.messages(), 2);
+
+			// "a\n" dropped, "b\n" left
+			TS_ASSERT(cbuffer.push('c'));
+			TS_ASSERT(cbuffer.push('d'));
+			TS_ASSERT_EQUALS(cbuffer.messages(), 1);
+
+			// "b" dropped, "\n" and "cd\n" left
+			TS_ASSERT(cbuffer.push('\n'));
+			TS_ASSERT_EQUALS(cbuffer.messages(), 2);
+			TS_ASSERT(cbuffer.popmsg(data, 4, &n));
+			TS_ASSERT_EQUALS(n, 0);
+			TS_ASSERT(cbuffer.popmsg(data, 4, &n));
+			TS_ASSERT_EQUALS(n, 2);
+			TS_ASSERT_EQUALS(data[0], 'c');
+
+			// bulk, only the last 4 stay
+			cbuffer.push((const uint8_t*)"1\n2\n3\n", 6);
+			TS_ASSERT_EQUALS(cbuffer.messages(), 2);
+			TS_ASSERT_EQUALS(cbuffer.len(), 4);
+		}
+};
+
+class TestSuiteDelim : public CxxTest::TestSuite
+{
+	public:
+		void testDelim(void)
+		{
+			CBufferD<uint8_t, uint8_t> cbuffer {(const uint8_t*)"\r\n", 2, 32};
+			uint8_t data[32];
+			uint8_t n;
+
+			TS_ASSERT_THROWS((CBufferD<uint8_t, uint8_t> {data, 0, 8}),
+					std::invalid_argument);
+
+			// a message arriving a piece at a time, "\r" alone is no end.
+			cbuffer.push((const uint8_t*)"GET /\r", 6);
+			TS_ASSERT(!cbuffer.find(&n));
+			TS_ASSERT_EQUALS(cbuffer.scanned(), 6);
+			TS_ASSERT(!cbuffer.popd(data, 32, &n));
+			cbuffer.push((const uint8_t*)"x\r", 2);
+			TS_ASSERT(!cbuffer.find(&n));
+			TS_ASSERT_EQUALS(cbuffer.scanned(), 8);
+			cbuffer.push((const uint8_t*)"\nab", 3);
+
+			// only the new objects are scanned
+			TS_ASSERT(cbuffer.find(&n));
+			TS_ASSERT_EQUALS(n, 7);
+			TS_ASSERT_EQUALS(cbuffer.scanned(), 9);
+
+			// too small, then whole with the delimiter
+			TS_ASSERT(!cbuffer.popd(data, 8, &n));
+			TS_ASSERT(cbuffer.popd(data, 9, &n));
+			TS_ASSERT_EQUALS(n, 7);
+			TS_ASSERT_EQUALS(data[6], 'x');
+			TS_ASSERT_EQUALS(data[8], '\n');
+			TS_ASSERT_EQUALS(cbuffer.len(), 2);
+
+			// popping before the partial match keeps the state
+			cbuffer.push('\r');
+			TS_ASSERT(!cbuffer.find(&n));
+			TS_ASSERT(cbuffer.popc(data));
+			TS_ASSERT_EQUALS(cbuffer.scanned(), 2);
+			cbuffer.push('\n');
+			TS_ASSERT(cbuffer.find(&n));
+			TS_ASSERT_EQUALS(n, 1);
+		}
+
+		void testOverlap(void)
+		{
+			CBufferD<uint8_t, uint8_t> aab {(const uint8_t*)"aab", 3, 16};
+			CBufferD<uint8_t, uint8_t> abab {(const uint8_t*)"abab", 4, 16};
+			CBufferD<uint8_t, uint8_t> aa {(const uint8_t*)"aa", 2, 16};
+			uint8_t data[16];
+			uint8_t n;
+
+			// the mismatch falls back to "aa", not to the start.
+			aab.push((const uint8_t*)"xaaa", 4);
+			TS_ASSERT(!aab.find(&n));
+			aab.push('b');
+			TS_ASSERT(aab.find(&n));
+			TS_ASSERT_EQUALS(n, 2);
+
+			// "ababab" ends at the first "abab"
+			abab.push((const uint8_t*)"aba", 3);
+			TS_ASSERT(!abab.find(&n));
+			abab.push((const uint8_t*)"bab", 3);
+			TS_ASSERT(abab.find(&n));
+			TS_ASSERT_EQUALS(n, 0);
+			TS_ASSERT(abab.popd(data, 16, &n));
+			TS_ASSERT_EQUALS(abab.len(), 2);
+			TS_ASSERT(!abab.find(&n));
+			abab.push((const uint8_t*)"ab", 2);
+			TS_ASSERT(abab.find(&n));
+			TS_ASSERT_EQUALS(n, 0);
+
+			// "aaa" is a message "" and a partial "a"
+			aa.push((const uint8_t*)"aaa", 3);
+			TS_ASSERT(aa.popd(data, 16, &n));
+			TS_ASSERT_EQUALS(n, 0);
+			TS_ASSERT(!aa.find(&n));
+			aa.push('a');
+			TS_ASSERT(aa.find(&n));
+			TS_ASSERT_EQUALS(n, 0);
+		}
+
+		void testOverwrite(void)
+		{
+			CBufferD<uint8_t, uint8_t> cbuffer {(const uint8_t*)"\n", 1, 4};
+			uint8_t n;
+
+			// the emplace() drop shifts the search.
+			cbuffer.overwrite(true);
+			cbuffer.push((const uint8_t*)"abcd", 4);
+			TS_ASSERT(!cbuffer.find(&n));
+			TS_ASSERT_EQUALS(cbuffer.scanned(), 4);
+			TS_ASSERT(cbuffer.emplace('\n'));
+			TS_ASSERT_EQUALS(cbuffer.scanned(), 3);
+			TS_ASSERT(cbuffer.find(&n));
+			TS_ASSERT_EQUALS(n, 3);
+		}
+
+		// random operations, checked against a brute force search.
+		void testRandom(void)
+		{
+			const std::string delim {"aab"};
+			CBufferD<uint8_t, uint8_t> cbuffer {(const uint8_t*)delim.data(),
+				(uint8_t)delim.size(), 8};
+			std::string model;
+			uint8_t data[8];
+			uint8_t n, j;
+			uint32_t seed {1};
+
+			for (auto i = 0; i < 20000; i++) {
+				seed = seed * 1103515245 + 12345;
+				const uint8_t r { (uint8_t)(seed >> 16) };
+				const uint8_t c { (uint8_t)("aab"[r % 3]) };
+				const size_t m { model.find(delim) };
+
+				switch ((r >> 2) % 8) {
+				case 0:
+					cbuffer.overwrite(r & 0x80);
+					break;
+				case 1:
+				case 2:
+					if (cbuffer.push(c)) {
+						if (model.size() == 8)
+							model.erase(0, 1);
+
+						model += (char)c;
+					}
+
+					break;
+				case 3:
+					if (cbuffer.emplace(c)) {
+						if (model.size() == 8)
+							model.erase(0, 1);
+
+						model += (char)c;
+					}
+
+					break;
+				case 4:
+					if (cbuffer.popc(data))
+						model.erase(0, 1);
+
+					break;
+				case 5:
+					j = cbuffer.consume(r % 4);
+					TS_ASSERT_EQUALS(j, std::min<size_t>(r % 4, model.size()));
+					model.erase(0, j);
+					break;
+				case 6:
+					TS_ASSERT_EQUALS(cbuffer.find(&n), m != std::string::npos);
+
+					if (m != std::string::npos)
+						TS_ASSERT_EQUALS(n, m);
+
+					break;
+				default:
+					if (cbuffer.popd(data, 8, &n)) {
+						TS_ASSERT_EQUALS(n, m);
+						model.erase(0, n + delim.size());
+					} else {
+						TS_ASSERT_EQUALS(m, std::string::npos);
+					}
+				}
+
+				TS_ASSERT_EQUALS(cbuffer.len(), model.size());
+			}
+		}
 };
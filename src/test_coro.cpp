@@ -0,0 +1,117 @@
+/*
+ * Circular Buffer, an object oriented circular buffer.
+ * Copyright (C) 2015-2021 Enrico Rossi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <iostream>
+#include <cstdint>
+#include <vector>
+#include "circular_buffer_coro.h"
+#include "coro_executor.h"
+
+const uint32_t BUF_SIZE { 16 }; // buffer size
+const uint32_t PRODUCERS { 10 }; // producer coroutines
+const uint32_t CONSUMERS { 1000 }; // consumer coroutines
+const uint32_t COUNT { 100000 }; // objects per producer
+const uint32_t MSG_SIZE { 8 }; // async_pop(data, n) chunk
+
+using namespace std;
+
+using Buffer = CBufferAsync<uint32_t, uint32_t, Executor>;
+
+// Push id * COUNT + 1 .. (id + 1) * COUNT.
+Task producer(Buffer& cbuffer, uint32_t id)
+{
+	for (uint32_t i = 1; i <= COUNT; i++)
+		co_await cbuffer.async_push(id * COUNT + i);
+}
+
+/* Pop n objects and mark them seen.
+ *
+ * The odd consumers pop in batches.
+ */
+Task consumer(Buffer& cbuffer, uint32_t id, uint32_t n, vector<uint8_t>& seen)
+{
+	uint32_t message[MSG_SIZE];
+	uint32_t len;
+
+	while (n) {
+		if (id & 1) {
+			len = co_await cbuffer.async_pop(message, min(n, MSG_SIZE));
+		} else {
+			message[0] = co_await cbuffer.async_pop();
+			len = 1;
+		}
+
+		for (uint32_t i = 0; i < len; i++)
+			seen[message[i]]++;
+
+		n -= len;
+	}
+}
+
+// Pop nothing, it must not wait.
+Task zero(Buffer& cbuffer, uint32_t& len)
+{
+	uint32_t message[1];
+
+	len = co_await cbuffer.async_pop(message, 0);
+}
+
+int main() {
+	Executor executor;
+	Buffer cbuffer {executor, BUF_SIZE};
+	vector<uint8_t> seen (PRODUCERS * COUNT + 1);
+	const uint32_t share { PRODUCERS * COUNT / CONSUMERS };
+	uint32_t errors {0};
+
+	cout << endl << "Test circular buffer (coroutines)." << endl;
+	cout << "Copyright (C) 2015-2021 Enrico Rossi - GNU GPL" << endl;
+	cout << endl << PRODUCERS << " producers push " << COUNT;
+	cout << " objects each to " << CONSUMERS << " consumers." << endl << endl;
+
+	// zero length pop on the empty buffer, the push is not handed off.
+	{
+		Buffer empty {executor, BUF_SIZE};
+		uint32_t len {1};
+
+		zero(empty, len);
+
+		if (len || !empty.push(1) || (empty.len() != 1))
+			errors++;
+	}
+
+	// the consumers wait on the empty buffer.
+	for (uint32_t id = 0; id < CONSUMERS; id++)
+		consumer(cbuffer, id, share, seen);
+
+	for (uint32_t id = 0; id < PRODUCERS; id++)
+		producer(cbuffer, id);
+
+	executor.run();
+
+	if (cbuffer.len())
+		errors++;
+
+	for (uint32_t i = 1; i < seen.size(); i++)
+		if (seen[i] != 1)
+			errors++;
+
+	cout << "Errors: " << errors << (errors ? " FAIL" : " OK") << endl;
+
+	return (errors ? 1 : 0);
+}
@@ -0,0 +1,103 @@
+/*
+ * Circular Buffer, an object oriented circular buffer.
+ * Copyright (C) 2015-2021 Enrico Rossi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <iostream>
+#include <cstdint>
+#include <thread>
+#include <sys/epoll.h>
+#include "circular_buffer_eventfd.h"
+
+const uint32_t BUF_SIZE { 1000 }; // buffer size
+const uint32_t MSG_SIZE { 64 }; // pop() chunk
+const uint32_t BURST { 100 }; // objects pushed in a row
+const uint32_t COUNT { 1000000 }; // objects to transfer
+
+using namespace std;
+
+// Producer thread, push 1..COUNT in bursts.
+void producer(CBufferEventfd<uint32_t, uint32_t>& cbuffer)
+{
+	uint32_t i {1};
+
+	while (i <= COUNT) {
+		if (cbuffer.push(i))
+			i++;
+		else
+			this_thread::yield();
+
+		// let the consumer sleep on the fd between the bursts.
+		if (!(i % BURST))
+			this_thread::yield();
+	}
+}
+
+// Consumer thread, wait on epoll and drain the buffer.
+void consumer(CBufferEventfd<uint32_t, uint32_t>& cbuffer, uint32_t& errors,
+		uint32_t& wakeups)
+{
+	uint32_t message[MSG_SIZE];
+	uint32_t expected {1};
+	uint32_t len;
+	struct epoll_event ev {};
+	const int ep { epoll_create1(EPOLL_CLOEXEC) };
+
+	ev.events = EPOLLIN;
+	epoll_ctl(ep, EPOLL_CTL_ADD, cbuffer.fd(), &ev);
+
+	while (expected <= COUNT) {
+		// a lost notification ends in the timeout.
+		if (epoll_wait(ep, &ev, 1, 1000) != 1) {
+			errors++;
+			break;
+		}
+
+		wakeups++;
+
+		do {
+			while ((len = cbuffer.pop(message, MSG_SIZE)))
+				for (uint32_t i = 0; i < len; i++, expected++)
+					if (message[i] != expected)
+						errors++;
+		} while (cbuffer.rearm());
+	}
+
+	close(ep);
+}
+
+int main() {
+	CBufferEventfd<uint32_t, uint32_t> cbuffer {BUF_SIZE};
+	uint32_t errors {0};
+	uint32_t wakeups {0};
+
+	cout << endl << "Test circular buffer (eventfd)." << endl;
+	cout << "Copyright (C) 2015-2021 Enrico Rossi - GNU GPL" << endl;
+	cout << endl << "Transfer " << COUNT << " objects to a consumer";
+	cout << " waiting on epoll." << endl << endl;
+
+	thread c {consumer, ref(cbuffer), ref(errors), ref(wakeups)};
+	thread p {producer, ref(cbuffer)};
+
+	p.join();
+	c.join();
+
+	cout << "Wake ups: " << wakeups << endl;
+	cout << "Errors: " << errors << (errors ? " FAIL" : " OK") << endl;
+
+	return (errors ? 1 : 0);
+}
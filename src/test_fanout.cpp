@@ -0,0 +1,146 @@
+/*
+ * Circular Buffer, an object oriented circular buffer.
+ * Copyright (C) 2015-2021 Enrico Rossi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <iostream>
+#include <cstdint>
+#include <thread>
+#include "circular_buffer_fanout.h"
+
+const uint32_t BUF_SIZE { 1000 }; // buffer size
+const uint32_t MSG_SIZE { 64 }; // pop() chunk
+const uint32_t COUNT { 2000000 }; // objects to transfer
+
+using namespace std;
+
+using Fanout = CBufferFanout<uint32_t, uint32_t, 3>;
+
+// Writer thread, push 1..COUNT in sequence, alternate push() of
+// a single object and of a batch.
+void writer(Fanout& cbuffer)
+{
+	uint32_t message[MSG_SIZE];
+	uint32_t i {1};
+	uint32_t len;
+
+	while (i <= COUNT) {
+		if (i & 1) {
+			len = cbuffer.push(i) ? 1 : 0;
+		} else {
+			len = min(MSG_SIZE, COUNT - i + 1);
+
+			for (uint32_t j = 0; j < len; j++)
+				message[j] = i + j;
+
+			len = cbuffer.push(message, len);
+		}
+
+		if (len)
+			i += len;
+		else
+			this_thread::yield();
+	}
+}
+
+/* Reader thread checking the sequence.
+ * 0: popc(), 1: pop() and every third batch read again with reset(),
+ * 2: peek() and consume() in place.
+ */
+void reader(Fanout& cbuffer, unsigned int id, uint32_t& errors)
+{
+	CBufferSegment<uint32_t, const uint32_t> first, second;
+	uint32_t message[MSG_SIZE];
+	uint32_t expected {1};
+	uint32_t batch {0};
+	uint32_t len;
+
+	while (expected <= COUNT) {
+		if (id == 0) {
+			len = cbuffer.popc(id, message) ? 1 : 0;
+		} else if (id == 1) {
+			len = cbuffer.pop(id, message, MSG_SIZE);
+		} else {
+			len = cbuffer.peek(id, first, second);
+
+			for (uint32_t i = 0; i < len; i++) {
+				const uint32_t c { i < first.len ? first.data[i] :
+					second.data[i - first.len] };
+
+				if (c != expected + i)
+					errors++;
+			}
+
+			cbuffer.consume(id, len);
+		}
+
+		if (!len) {
+			this_thread::yield();
+			continue;
+		}
+
+		if (id != 2)
+			for (uint32_t i = 0; i < len; i++)
+				if (message[i] != expected + i)
+					errors++;
+
+		if ((id == 1) && !(++batch % 3)) {
+			cbuffer.reset(id);
+		} else {
+			cbuffer.commit(id);
+			expected += len;
+		}
+
+		// let the writer and the other readers run with objects left.
+		if (!((expected + id) % 997))
+			this_thread::yield();
+	}
+
+	if (cbuffer.len(id))
+		errors++;
+}
+
+int main() {
+	Fanout cbuffer {BUF_SIZE};
+	uint32_t errors[Fanout::readers()] {};
+	thread readers[Fanout::readers()];
+
+	cout << endl << "Test circular buffer (fan-out)." << endl;
+	cout << "Copyright (C) 2015-2021 Enrico Rossi - GNU GPL" << endl;
+	cout << endl << "Transfer " << COUNT << " objects from a writer";
+	cout << " to " << Fanout::readers() << " reader threads." << endl << endl;
+
+	for (unsigned int id = 0; id < Fanout::readers(); id++)
+		readers[id] = thread {reader, ref(cbuffer), id, ref(errors[id])};
+
+	thread w {writer, ref(cbuffer)};
+
+	w.join();
+
+	for (auto& r : readers)
+		r.join();
+
+	for (unsigned int id = 0; id < Fanout::readers(); id++) {
+		cout << "Reader " << id << " errors: " << errors[id];
+		cout << (errors[id] ? " FAIL" : " OK") << endl;
+
+		if (errors[id])
+			return (1);
+	}
+
+	return (0);
+}
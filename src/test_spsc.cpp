@@ -0,0 +1,267 @@
+/*
+ * Circular Buffer, an object oriented circular buffer.
+ * Copyright (C) 2015-2021 Enrico Rossi
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <cstdint>
+#include <chrono>
+#include <thread>
+#include "circular_buffer_spsc_shadow.h"
+#include "circular_buffer_wait_park.h"
+
+const uint32_t BUF_SIZE { 1000 }; // buffer size
+const uint32_t MSG_SIZE { 64 }; // pop() chunk
+const uint32_t COUNT { 10000000 }; // objects to transfer
+const uint32_t WAIT_COUNT { 100000 }; // objects to transfer blocking
+
+using namespace std;
+
+// Producer thread, push 1..COUNT in sequence.
+// alternate push() and batches written in place with reserve().
+void producer(CBufferSPSC<uint32_t, uint32_t>& cbuffer)
+{
+	CBufferSegment<uint32_t, uint32_t> first, second;
+	uint32_t i {1};
+	uint32_t len;
+
+	while (i <= COUNT) {
+		if (i & 1) {
+			if (cbuffer.push(i))
+				i++;
+			else
+				this_thread::yield();
+		} else {
+			len = cbuffer.reserve(first, second, min(MSG_SIZE, COUNT - i + 1));
+
+			for (uint32_t j = 0; j < first.len; j++)
+				first.data[j] = i + j;
+
+			for (uint32_t j = 0; j < second.len; j++)
+				second.data[j] = i + first.len + j;
+
+			if (len)
+				i += cbuffer.publish(len);
+			else
+				this_thread::yield();
+		}
+	}
+}
+
+// Consumer thread, alternate popc() and pop() checking the sequence.
+void consumer(CBufferSPSC<uint32_t, uint32_t>& cbuffer, uint32_t& errors)
+{
+	uint32_t message[MSG_SIZE];
+	uint32_t expected {1};
+	uint32_t len;
+
+	while (expected <= COUNT) {
+		if (expected & 1) {
+			len = cbuffer.popc(message) ? 1 : 0;
+		} else {
+			len = cbuffer.pop(message, MSG_SIZE);
+		}
+
+		if (!len)
+			this_thread::yield();
+
+		for (uint32_t i = 0; i < len; i++, expected++)
+			if (message[i] != expected)
+				errors++;
+	}
+}
+
+// Transactional consumer, every third batch is rolled back
+// with reset() and read again, the others are committed.
+void consumer_shadow(CBufferSPSCS<uint32_t, uint32_t>& cbuffer,
+		uint32_t& errors)
+{
+	uint32_t message[MSG_SIZE];
+	uint32_t expected {1};
+	uint32_t batch {0};
+	uint32_t len;
+
+	while (expected <= COUNT) {
+		if (expected & 1)
+			len = cbuffer.popc(message) ? 1 : 0;
+		else
+			len = cbuffer.pop(message, MSG_SIZE);
+
+		if (!len) {
+			this_thread::yield();
+			continue;
+		}
+
+		for (uint32_t i = 0; i < len; i++)
+			if (message[i] != expected + i)
+				errors++;
+
+		if (++batch % 3) {
+			cbuffer.commit();
+			expected += len;
+		} else {
+			cbuffer.reset();
+		}
+	}
+}
+
+// Blocking producer and consumer with the wait strategy W.
+template <typename W>
+void producer_wait(CBufferSPSC<uint32_t, uint32_t, W>& cbuffer)
+{
+	for (uint32_t i = 1; i <= WAIT_COUNT; i++)
+		while (!cbuffer.push_wait(i, chrono::milliseconds(100)));
+}
+
+template <typename W>
+void consumer_wait(CBufferSPSC<uint32_t, uint32_t, W>& cbuffer,
+		uint32_t& errors)
+{
+	uint32_t message[MSG_SIZE];
+	uint32_t expected {1};
+	uint32_t len;
+
+	while (expected <= WAIT_COUNT) {
+		if (expected & 1)
+			len = cbuffer.popc_wait(message, chrono::milliseconds(100)) ? 1 : 0;
+		else
+			len = cbuffer.pop_wait(message, MSG_SIZE, chrono::milliseconds(100));
+
+		for (uint32_t i = 0; i < len; i++, expected++)
+			if (message[i] != expected)
+				errors++;
+	}
+}
+
+// Blocking transactional consumer, popc_wait(), pop_wait() and
+// popm() read from the shadow index, every third batch is rolled back.
+template <typename W>
+void consumer_wait(CBufferSPSCS<uint32_t, uint32_t, W>& cbuffer,
+		uint32_t& errors)
+{
+	uint32_t message[MSG_SIZE];
+	uint32_t expected {1};
+	uint32_t batch {0};
+	uint32_t eom;
+	uint32_t len;
+
+	while (expected <= WAIT_COUNT) {
+		if (expected & 1) {
+			len = cbuffer.popc_wait(message, chrono::milliseconds(100)) ? 1 : 0;
+		} else if (expected & 2) {
+			len = cbuffer.pop_wait(message, MSG_SIZE, chrono::milliseconds(100));
+		} else {
+			// 0 is never pushed, tells if the EOM has been read.
+			fill(message, message + MSG_SIZE, 0);
+			eom = expected + 2;
+			len = cbuffer.popm(message, MSG_SIZE, eom);
+
+			if ((len < MSG_SIZE) && (message[len] == eom))
+				len++;
+		}
+
+		if (!len)
+			continue;
+
+		for (uint32_t i = 0; i < len; i++)
+			if (message[i] != expected + i)
+				errors++;
+
+		if (++batch % 3) {
+			cbuffer.commit();
+			expected += len;
+		} else {
+			cbuffer.reset();
+		}
+	}
+}
+
+// Transfer with push_wait() and popc_wait()/pop_wait(), B is
+// CBufferSPSC or CBufferSPSCS.
+template <typename W, template <typename, typename, typename> class B = CBufferSPSC>
+void run_wait(const char* name, uint32_t& errors)
+{
+	B<uint32_t, uint32_t, W> cbuffer {BUF_SIZE};
+	uint32_t c;
+
+	auto t0 = chrono::steady_clock::now();
+	thread wc {[&] { consumer_wait(cbuffer, errors); }};
+	thread wp {[&] { producer_wait(cbuffer); }};
+
+	wp.join();
+	wc.join();
+	chrono::duration<double, micro> us = chrono::steady_clock::now() - t0;
+
+	cout << name << ": " << WAIT_COUNT / us.count() << " Mops/s" << endl;
+
+	// nothing to pop, the timeout expires.
+	t0 = chrono::steady_clock::now();
+
+	if (cbuffer.popc_wait(&c, chrono::milliseconds(10)))
+		errors++;
+
+	if ((chrono::steady_clock::now() - t0) < chrono::milliseconds(10))
+		errors++;
+
+	if (cbuffer.len())
+		errors++;
+}
+
+int main() {
+	CBufferSPSC<uint32_t, uint32_t> cbuffer {BUF_SIZE};
+	CBufferSPSCS<uint32_t, uint32_t> sbuffer {BUF_SIZE};
+	uint32_t errors {0};
+
+	cout << endl << "Test circular buffer (lock-free SPSC)." << endl;
+	cout << "Copyright (C) 2015-2021 Enrico Rossi - GNU GPL" << endl;
+	cout << endl << "Transfer " << COUNT << " objects from a producer";
+	cout << " to a consumer thread." << endl << endl;
+
+	auto t0 = chrono::steady_clock::now();
+	thread c {consumer, ref(cbuffer), ref(errors)};
+	thread p {producer, ref(cbuffer)};
+
+	p.join();
+	c.join();
+	chrono::duration<double, micro> us = chrono::steady_clock::now() - t0;
+
+	cout << COUNT / us.count() << " Mops/s" << endl;
+
+	cout << "Transactional consumer with commit() and reset()." << endl;
+	thread sc {consumer_shadow, ref(sbuffer), ref(errors)};
+	thread sp {producer, ref(sbuffer)};
+
+	sp.join();
+	sc.join();
+
+	if (sbuffer.len())
+		errors++;
+
+	cout << "Blocking push_wait() and popc_wait()." << endl;
+	run_wait<CBufferWaitSpin>("spin", errors);
+	run_wait<CBufferWaitYield<>>("yield", errors);
+	run_wait<CBufferWaitPark>("park", errors);
+	run_wait<CBufferWaitPark, CBufferSPSCS>("park, shadow", errors);
+
+	if (cbuffer.len())
+		errors++;
+
+	cout << "Errors: " << errors << (errors ? " FAIL" : " OK") << endl;
+
+	return (errors ? 1 : 0);
+}